@@ -0,0 +1,491 @@
+#include "archivewriter.h"
+#include <QBuffer>
+#include <QtEndian>
+#include <array>
+#include <cstring>
+
+// ZIP 格式常量
+static constexpr quint32 ZipLocalHeaderSignature = 0x04034b50;
+static constexpr quint32 ZipDataDescriptorSignature = 0x08074b50;
+static constexpr quint32 ZipCentralHeaderSignature = 0x02014b50;
+static constexpr quint32 Zip64EndOfCentralDirectorySignature = 0x06064b50;
+static constexpr quint32 Zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+static constexpr quint32 ZipEndOfCentralDirectorySignature = 0x06054b50;
+static constexpr quint16 ZipVersion = 20;   // 2.0：存储 + 数据描述符
+static constexpr quint16 Zip64Version = 45; // 4.5：ZIP64
+static constexpr quint16 ZipFlags = 0x0808; // 位3：数据描述符；位11：文件名为UTF-8
+static constexpr quint32 Zip32Limit = 0xffffffffu;
+static constexpr quint16 Zip16Limit = 0xffffu;
+
+// tar 块大小，以及 ustar 头中 12 字节八进制长度字段能表示的最大值
+static constexpr int TarBlockSize = 512;
+static constexpr qint64 TarMaxOctalSize = 077777777777LL;
+
+static void appendLE16(QByteArray &data, quint16 value)
+{
+    char bytes[2];
+    qToLittleEndian(value, bytes);
+    data.append(bytes, sizeof(bytes));
+}
+
+static void appendLE32(QByteArray &data, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    data.append(bytes, sizeof(bytes));
+}
+
+static void appendLE64(QByteArray &data, quint64 value)
+{
+    char bytes[8];
+    qToLittleEndian(value, bytes);
+    data.append(bytes, sizeof(bytes));
+}
+
+// 标准 CRC-32（多项式 0xEDB88320），ZIP 条目校验使用
+static quint32 updateCrc32(quint32 crc, const char *data, qint64 size)
+{
+    static const std::array<quint32, 256> table = []() {
+        std::array<quint32, 256> result{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (0xedb88320u ^ (value >> 1)) : (value >> 1);
+            }
+            result[i] = value;
+        }
+        return result;
+    }();
+
+    crc = ~crc;
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<quint8>(data[i])) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// ZIP 使用 MS-DOS 格式的本地时间（2秒精度，1980年起）
+static void toDosDateTime(const QDateTime &dateTime, quint16 *dosTime, quint16 *dosDate)
+{
+    const QDateTime local = dateTime.toLocalTime();
+    const QDate date = local.date();
+    const QTime time = local.time();
+    if (!date.isValid() || date.year() < 1980) {
+        *dosTime = 0;
+        *dosDate = (1 << 5) | 1; // 1980-01-01
+        return;
+    }
+    *dosTime = quint16((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+    *dosDate = quint16(((date.year() - 1980) << 9) | (date.month() << 5) | date.day());
+}
+
+// ustar 头中的八进制数字段：width 包括结尾的 NUL
+static void writeOctalField(char *field, int width, qint64 value)
+{
+    const QByteArray digits = QByteArray::number(value, 8).rightJustified(width - 1, '0');
+    std::memcpy(field, digits.constData(), width - 1);
+    field[width - 1] = '\0';
+}
+
+// pax 扩展头中的一条记录："<长度> <键>=<值>\n"，长度包括长度数字本身
+static QByteArray paxRecord(const QByteArray &key, const QByteArray &value)
+{
+    const QByteArray body = " " + key + "=" + value + "\n";
+    int length = body.size() + 1;
+    while (true) {
+        const int next = QByteArray::number(length).size() + body.size();
+        if (next == length) {
+            break;
+        }
+        length = next;
+    }
+    return QByteArray::number(length) + body;
+}
+
+ArchiveWriter::ArchiveWriter(Format format)
+    : m_format(format),
+      m_failed(false)
+{
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+    if (m_file.isOpen()) {
+        abort();
+    }
+}
+
+bool ArchiveWriter::open(const QString &fileName)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_errorString = QString("无法创建归档文件: %1 (%2)").arg(fileName, m_file.errorString());
+        return false;
+    }
+    m_chunk.resize(CopyChunkSize);
+    m_zipEntries.clear();
+    m_failed = false;
+    return true;
+}
+
+bool ArchiveWriter::addFile(const QString &name, QIODevice *source, qint64 size, const QDateTime &modified,
+                            QCryptographicHash *hash)
+{
+    if (!isWritable()) {
+        return false;
+    }
+
+    const QByteArray entryName = name.toUtf8();
+
+    if (m_format == Tar) {
+        if (!writeTarHeader(entryName, size, modified)) {
+            return false;
+        }
+        const bool complete = copyData(source, size, hash, nullptr);
+        if (!writePadding((TarBlockSize - size % TarBlockSize) % TarBlockSize)) {
+            return false;
+        }
+        return complete;
+    }
+
+    ZipEntry entry;
+    entry.name = entryName;
+    entry.size = size;
+    entry.offset = m_file.pos();
+    toDosDateTime(modified, &entry.dosTime, &entry.dosDate);
+
+    if (!writeZipLocalHeader(entry)) {
+        return false;
+    }
+    const bool complete = copyData(source, size, hash, &entry.crc);
+    if (!isWritable() || !writeZipDataDescriptor(entry)) {
+        return false;
+    }
+    m_zipEntries.append(entry);
+    return complete;
+}
+
+bool ArchiveWriter::addData(const QString &name, const QByteArray &data, const QDateTime &modified)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    return addFile(name, &buffer, data.size(), modified);
+}
+
+bool ArchiveWriter::close()
+{
+    if (!isWritable()) {
+        abort();
+        return false;
+    }
+
+    bool ok = false;
+    if (m_format == Tar) {
+        // 归档以两个全零块结束
+        ok = writePadding(TarBlockSize * 2);
+    } else {
+        ok = writeZipCentralDirectory();
+    }
+
+    if (!ok || !m_file.flush()) {
+        if (m_errorString.isEmpty()) {
+            m_errorString = m_file.errorString();
+        }
+        abort();
+        return false;
+    }
+
+    m_file.close();
+    return true;
+}
+
+void ArchiveWriter::abort()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_file.remove();
+    m_zipEntries.clear();
+}
+
+bool ArchiveWriter::writeTarHeader(const QByteArray &name, qint64 size, const QDateTime &modified)
+{
+    const qint64 mtime = qMax<qint64>(0, modified.toSecsSinceEpoch());
+
+    // 名称放得进 ustar 的 name/prefix 字段且长度可用八进制表示时，直接写普通头
+    const bool fitsName = name.size() <= 100;
+    int split = -1;
+    if (!fitsName && name.size() <= 256) {
+        // 在 '/' 处拆分为 prefix（最多155字节）和 name（最多100字节）
+        for (int i = name.size() - 1; i > 0; --i) {
+            if (name.at(i) == '/' && i <= 155 && name.size() - i - 1 <= 100 && name.size() - i - 1 > 0) {
+                split = i;
+                break;
+            }
+        }
+    }
+
+    if ((fitsName || split > 0) && size <= TarMaxOctalSize) {
+        return writeTarBlock(name, size, mtime, '0');
+    }
+
+    // 否则先写一个 pax 扩展头，记录完整路径和长度
+    QByteArray records = paxRecord("path", name);
+    if (size > TarMaxOctalSize) {
+        records += paxRecord("size", QByteArray::number(size));
+    }
+    if (!writeTarBlock("././@PaxHeader", records.size(), mtime, 'x')
+        || !write(records)
+        || !writePadding((TarBlockSize - records.size() % TarBlockSize) % TarBlockSize)) {
+        return false;
+    }
+
+    // 紧随其后的普通头只保存截断的名称，实际值以 pax 记录为准
+    return writeTarBlock(name.left(100), qMin(size, TarMaxOctalSize), mtime, '0');
+}
+
+bool ArchiveWriter::writeTarBlock(const QByteArray &name, qint64 size, qint64 mtime, char type)
+{
+    char header[TarBlockSize];
+    std::memset(header, 0, sizeof(header));
+
+    // 超过100字节的名称在 '/' 处拆分到 prefix 字段（调用方已确认可以拆分）
+    QByteArray entryName = name;
+    if (entryName.size() > 100) {
+        const int split = entryName.lastIndexOf('/', 155);
+        std::memcpy(header + 345, entryName.constData(), split);
+        entryName = entryName.mid(split + 1);
+    }
+    std::memcpy(header, entryName.constData(), qMin<qsizetype>(entryName.size(), 100));
+
+    writeOctalField(header + 100, 8, 0644);  // mode
+    writeOctalField(header + 108, 8, 0);     // uid
+    writeOctalField(header + 116, 8, 0);     // gid
+    writeOctalField(header + 124, 12, size); // size
+    writeOctalField(header + 136, 12, mtime);
+    header[156] = type;
+    std::memcpy(header + 257, "ustar", 6);   // magic（包括结尾的NUL）
+    std::memcpy(header + 263, "00", 2);      // version
+
+    // 校验和：计算时校验和字段按8个空格计
+    std::memset(header + 148, ' ', 8);
+    unsigned int checksum = 0;
+    for (char byte : header) {
+        checksum += static_cast<unsigned char>(byte);
+    }
+    writeOctalField(header + 148, 7, checksum);
+    header[155] = ' ';
+
+    return write(header, sizeof(header));
+}
+
+bool ArchiveWriter::writeZipLocalHeader(const ZipEntry &entry)
+{
+    const bool zip64 = entry.size >= Zip32Limit;
+
+    // 使用数据描述符时本地头中的 CRC 和长度为 0；ZIP64 条目的长度放在扩展字段中
+    QByteArray extra;
+    if (zip64) {
+        appendLE16(extra, 0x0001);
+        appendLE16(extra, 16);
+        appendLE64(extra, 0);
+        appendLE64(extra, 0);
+    }
+
+    QByteArray header;
+    header.reserve(30 + entry.name.size() + extra.size());
+    appendLE32(header, ZipLocalHeaderSignature);
+    appendLE16(header, zip64 ? Zip64Version : ZipVersion);
+    appendLE16(header, ZipFlags);
+    appendLE16(header, 0); // 存储，不压缩
+    appendLE16(header, entry.dosTime);
+    appendLE16(header, entry.dosDate);
+    appendLE32(header, 0);
+    appendLE32(header, zip64 ? Zip32Limit : 0);
+    appendLE32(header, zip64 ? Zip32Limit : 0);
+    appendLE16(header, quint16(entry.name.size()));
+    appendLE16(header, quint16(extra.size()));
+    header += entry.name;
+    header += extra;
+
+    return write(header);
+}
+
+bool ArchiveWriter::writeZipDataDescriptor(const ZipEntry &entry)
+{
+    QByteArray descriptor;
+    appendLE32(descriptor, ZipDataDescriptorSignature);
+    appendLE32(descriptor, entry.crc);
+    if (entry.size >= Zip32Limit) {
+        appendLE64(descriptor, quint64(entry.size));
+        appendLE64(descriptor, quint64(entry.size));
+    } else {
+        appendLE32(descriptor, quint32(entry.size));
+        appendLE32(descriptor, quint32(entry.size));
+    }
+    return write(descriptor);
+}
+
+bool ArchiveWriter::writeZipCentralDirectory()
+{
+    const qint64 directoryOffset = m_file.pos();
+
+    // 中央目录按条目分批拼接后写入
+    QByteArray directory;
+    for (const ZipEntry &entry : m_zipEntries) {
+        const bool sizeOverflow = entry.size >= Zip32Limit;
+        const bool offsetOverflow = entry.offset >= Zip32Limit;
+
+        // ZIP64 扩展字段只包含溢出的字段，顺序固定为：原始长度、压缩后长度、本地头偏移
+        QByteArray extra;
+        if (sizeOverflow || offsetOverflow) {
+            QByteArray fields;
+            if (sizeOverflow) {
+                appendLE64(fields, quint64(entry.size));
+                appendLE64(fields, quint64(entry.size));
+            }
+            if (offsetOverflow) {
+                appendLE64(fields, quint64(entry.offset));
+            }
+            appendLE16(extra, 0x0001);
+            appendLE16(extra, quint16(fields.size()));
+            extra += fields;
+        }
+
+        const quint16 version = extra.isEmpty() ? ZipVersion : Zip64Version;
+        appendLE32(directory, ZipCentralHeaderSignature);
+        appendLE16(directory, version); // version made by
+        appendLE16(directory, version); // version needed
+        appendLE16(directory, ZipFlags);
+        appendLE16(directory, 0);
+        appendLE16(directory, entry.dosTime);
+        appendLE16(directory, entry.dosDate);
+        appendLE32(directory, entry.crc);
+        appendLE32(directory, sizeOverflow ? Zip32Limit : quint32(entry.size));
+        appendLE32(directory, sizeOverflow ? Zip32Limit : quint32(entry.size));
+        appendLE16(directory, quint16(entry.name.size()));
+        appendLE16(directory, quint16(extra.size()));
+        appendLE16(directory, 0); // comment
+        appendLE16(directory, 0); // disk number
+        appendLE16(directory, 0); // internal attributes
+        appendLE32(directory, 0); // external attributes
+        appendLE32(directory, offsetOverflow ? Zip32Limit : quint32(entry.offset));
+        directory += entry.name;
+        directory += extra;
+
+        if (directory.size() >= CopyChunkSize) {
+            if (!write(directory)) {
+                return false;
+            }
+            directory.clear();
+        }
+    }
+    if (!write(directory)) {
+        return false;
+    }
+
+    const qint64 directorySize = m_file.pos() - directoryOffset;
+    const qint64 entryCount = m_zipEntries.size();
+    const bool zip64 = entryCount >= Zip16Limit || directorySize >= Zip32Limit || directoryOffset >= Zip32Limit;
+
+    QByteArray end;
+    if (zip64) {
+        const qint64 zip64EndOffset = m_file.pos();
+        appendLE32(end, Zip64EndOfCentralDirectorySignature);
+        appendLE64(end, 44); // 记录剩余部分的长度
+        appendLE16(end, Zip64Version);
+        appendLE16(end, Zip64Version);
+        appendLE32(end, 0);
+        appendLE32(end, 0);
+        appendLE64(end, quint64(entryCount));
+        appendLE64(end, quint64(entryCount));
+        appendLE64(end, quint64(directorySize));
+        appendLE64(end, quint64(directoryOffset));
+
+        appendLE32(end, Zip64EndOfCentralDirectoryLocatorSignature);
+        appendLE32(end, 0);
+        appendLE64(end, quint64(zip64EndOffset));
+        appendLE32(end, 1);
+    }
+
+    appendLE32(end, ZipEndOfCentralDirectorySignature);
+    appendLE16(end, 0);
+    appendLE16(end, 0);
+    appendLE16(end, zip64 ? Zip16Limit : quint16(entryCount));
+    appendLE16(end, zip64 ? Zip16Limit : quint16(entryCount));
+    appendLE32(end, zip64 ? Zip32Limit : quint32(directorySize));
+    appendLE32(end, zip64 ? Zip32Limit : quint32(directoryOffset));
+    appendLE16(end, 0); // comment
+
+    return write(end);
+}
+
+bool ArchiveWriter::copyData(QIODevice *source, qint64 size, QCryptographicHash *hash, quint32 *crc)
+{
+    qint64 remaining = size;
+    while (remaining > 0) {
+        const qint64 bytesRead = source->read(m_chunk.data(), qMin<qint64>(remaining, m_chunk.size()));
+        if (bytesRead <= 0) {
+            break;
+        }
+        if (hash) {
+            hash->addData(QByteArrayView(m_chunk.constData(), bytesRead));
+        }
+        if (crc) {
+            *crc = updateCrc32(*crc, m_chunk.constData(), bytesRead);
+        }
+        if (!write(m_chunk.constData(), bytesRead)) {
+            return false;
+        }
+        remaining -= bytesRead;
+    }
+
+    if (remaining == 0) {
+        return true;
+    }
+
+    // 数据源提前结束：以零字节补齐声明的长度，保证后续条目的位置正确
+    m_errorString = QString("读取条目数据失败: %1").arg(source->errorString());
+    std::memset(m_chunk.data(), 0, m_chunk.size());
+    while (remaining > 0 && isWritable()) {
+        const qint64 count = qMin<qint64>(remaining, m_chunk.size());
+        if (crc) {
+            *crc = updateCrc32(*crc, m_chunk.constData(), count);
+        }
+        write(m_chunk.constData(), count);
+        remaining -= count;
+    }
+    return false;
+}
+
+bool ArchiveWriter::writePadding(qint64 size)
+{
+    static const QByteArray zeros(TarBlockSize * 2, '\0');
+    while (size > 0) {
+        const qint64 count = qMin<qint64>(size, zeros.size());
+        if (!write(zeros.constData(), count)) {
+            return false;
+        }
+        size -= count;
+    }
+    return true;
+}
+
+bool ArchiveWriter::write(const QByteArray &data)
+{
+    return write(data.constData(), data.size());
+}
+
+bool ArchiveWriter::write(const char *data, qint64 size)
+{
+    if (m_failed) {
+        return false;
+    }
+    if (m_file.write(data, size) != size) {
+        m_errorString = QString("写入归档文件失败: %1").arg(m_file.errorString());
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
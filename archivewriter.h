@@ -0,0 +1,82 @@
+/**
+ * @file archivewriter.h
+ * @brief 流式归档写入（tar / zip，仅存储不压缩）
+ *
+ * 条目数据从任意 QIODevice 分块复制到归档文件，内存占用只有一个复制缓冲区；
+ * 整个归档按顺序写入，从不回写：zip 的 CRC 和长度记录在数据描述符中，超过 4GB 时自动使用 ZIP64，
+ * tar 的长文件名使用 pax 扩展头。图片本身已经压缩，存储模式几乎不损失体积。
+ */
+
+#ifndef ARCHIVEWRITER_H
+#define ARCHIVEWRITER_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QIODevice>
+#include <QList>
+#include <QString>
+
+class ArchiveWriter
+{
+public:
+    enum Format {
+        Tar,
+        Zip
+    };
+
+    explicit ArchiveWriter(Format format);
+    ~ArchiveWriter(); // 未调用 close() 时删除不完整的归档
+
+    bool open(const QString &fileName);
+
+    // 写入一个条目：size 为数据长度，数据从 source 分块复制；hash 不为空时同时计算数据的哈希。
+    // source 提前结束时以零字节补齐并返回 false，归档结构仍然完整，可以继续写入其他条目
+    bool addFile(const QString &name, QIODevice *source, qint64 size, const QDateTime &modified,
+                 QCryptographicHash *hash = nullptr);
+    bool addData(const QString &name, const QByteArray &data, const QDateTime &modified);
+
+    // 写入归档结尾（tar 结束块 / zip 中央目录）并关闭文件
+    bool close();
+    // 放弃写入并删除不完整的归档文件
+    void abort();
+
+    // 归档文件是否仍可写入（写文件失败后为 false）
+    bool isWritable() const { return m_file.isOpen() && !m_failed; }
+    qint64 bytesWritten() const { return m_file.pos(); }
+    QString errorString() const { return m_errorString; }
+
+private:
+    struct ZipEntry
+    {
+        QByteArray name;
+        quint32 crc = 0;
+        qint64 size = 0;
+        qint64 offset = 0;
+        quint16 dosTime = 0;
+        quint16 dosDate = 0;
+    };
+
+    bool writeTarHeader(const QByteArray &name, qint64 size, const QDateTime &modified);
+    bool writeTarBlock(const QByteArray &name, qint64 size, qint64 mtime, char type);
+    bool writeZipLocalHeader(const ZipEntry &entry);
+    bool writeZipDataDescriptor(const ZipEntry &entry);
+    bool writeZipCentralDirectory();
+    bool copyData(QIODevice *source, qint64 size, QCryptographicHash *hash, quint32 *crc);
+    bool writePadding(qint64 size);
+    bool write(const QByteArray &data);
+    bool write(const char *data, qint64 size);
+
+    // 复制缓冲区大小：足够大的顺序写入
+    static constexpr int CopyChunkSize = 1024 * 1024;
+
+    Format m_format;
+    QFile m_file;
+    QByteArray m_chunk;
+    QList<ZipEntry> m_zipEntries;
+    bool m_failed;
+    QString m_errorString;
+};
+
+#endif // ARCHIVEWRITER_H
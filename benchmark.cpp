@@ -0,0 +1,357 @@
+// 数据库性能基准测试（无界面）
+//
+// 生成合成图片库（N 张图片，深层和宽层分组树，可配置图片尺寸），依次测量导入、ID/分组查询、
+// 缩略图和原图读取、导出和删除分组的耗时，结果以 JSON 输出到标准输出，便于在不同提交之间对比。
+// 日志输出到标准错误。
+//
+// 用法：ImageDBBenchmark --images 2000 --depth 8 --width 32 --image-size 1920x1080 --label <提交>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <QtConcurrent>
+#include <cstdio>
+#include <utility>
+#include "database.h"
+
+namespace {
+
+// 基础缩略图的边界框（与 Database 中的缩略图尺寸一致）
+const QSize ThumbnailSize(140, 210);
+
+struct BenchmarkConfig
+{
+    int imageCount = 2000;
+    int depth = 8;          // 深层分组链的层数
+    int width = 32;         // 宽层分组的子分组数量
+    QSize imageSize = QSize(1920, 1080);
+    QByteArray imageFormat = "JPG";
+    int variants = 16;      // 生成的不同源文件数量（导入时循环使用）
+    int samples = 200;      // 读取测试抽样的图片数
+    int repeat = 20;        // 快速查询的重复次数
+    int lookups = 20000;    // 语句缓存对比的查询次数
+    QString label;
+    bool profile = false;   // 开启查询统计并输出（耗时包含统计本身的开销）
+};
+
+// 一项测量结果：总耗时、操作次数和每次操作的平均耗时
+QJsonObject timing(qint64 nsecs, qint64 operations)
+{
+    QJsonObject result;
+    result.insert("ms", nsecs / 1e6);
+    result.insert("ops", operations);
+    result.insert("usPerOp", operations > 0 ? nsecs / 1e3 / operations : 0.0);
+    return result;
+}
+
+// 生成一张带渐变和噪点的图片（噪点让 JPEG 体积接近真实照片）
+QImage syntheticImage(const QSize &size, int seed)
+{
+    QImage image(size, QImage::Format_RGB32);
+    QPainter painter(&image);
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, QColor::fromHsv((seed * 37) % 360, 200, 220));
+    gradient.setColorAt(1, QColor::fromHsv((seed * 37 + 180) % 360, 160, 60));
+    painter.fillRect(image.rect(), gradient);
+    painter.end();
+
+    QRandomGenerator random(quint32(seed) + 1);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const int noise = int(random.bounded(48u)) - 24;
+            line[x] = qRgb(qBound(0, qRed(line[x]) + noise, 255),
+                           qBound(0, qGreen(line[x]) + noise, 255),
+                           qBound(0, qBlue(line[x]) + noise, 255));
+        }
+    }
+    return image;
+}
+
+// 启动异步任务后等待对应的完成信号（信号可能在启动函数返回前就已发射）
+template <typename Signal>
+void waitForSignal(Database *database, Signal signal, const std::function<void()> &start)
+{
+    QEventLoop loop;
+    bool finished = false;
+    QObject::connect(database, signal, &loop, [&]() {
+        finished = true;
+        loop.quit();
+    });
+    start();
+    if (!finished) {
+        loop.exec();
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("ImageDBBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ImageDBManager database benchmark");
+    parser.addHelpOption();
+    const QCommandLineOption imagesOption("images", "Number of images to import.", "n", "2000");
+    const QCommandLineOption depthOption("depth", "Depth of the deep group chain.", "n", "8");
+    const QCommandLineOption widthOption("width", "Number of children in the wide group level.", "n", "32");
+    const QCommandLineOption sizeOption("image-size", "Synthetic image size (WxH).", "size", "1920x1080");
+    const QCommandLineOption formatOption("format", "Synthetic image format (JPG or PNG).", "format", "JPG");
+    const QCommandLineOption variantsOption("variants", "Number of distinct source files.", "n", "16");
+    const QCommandLineOption samplesOption("samples", "Images sampled for fetch benchmarks.", "n", "200");
+    const QCommandLineOption repeatOption("repeat", "Repetitions for fast queries.", "n", "20");
+    const QCommandLineOption lookupsOption("lookups", "Lookups for the statement cache comparison.", "n", "20000");
+    const QCommandLineOption dirOption("dir", "Working directory (default: temporary, removed on exit).", "path");
+    const QCommandLineOption labelOption("label", "Label stored in the results (e.g. commit id).", "text");
+    const QCommandLineOption profileOption("profile", "Enable the query profiler and include its snapshot.");
+    parser.addOptions({ imagesOption, depthOption, widthOption, sizeOption, formatOption, variantsOption,
+                        samplesOption, repeatOption, lookupsOption, dirOption, labelOption, profileOption });
+    parser.process(app);
+
+    BenchmarkConfig config;
+    config.imageCount = qMax(1, parser.value(imagesOption).toInt());
+    config.depth = qMax(1, parser.value(depthOption).toInt());
+    config.width = qMax(1, parser.value(widthOption).toInt());
+    const QStringList sizeParts = parser.value(sizeOption).split('x');
+    if (sizeParts.size() == 2) {
+        config.imageSize = QSize(qMax(1, sizeParts[0].toInt()), qMax(1, sizeParts[1].toInt()));
+    }
+    config.imageFormat = parser.value(formatOption).toUpper().toLatin1();
+    config.variants = qBound(1, parser.value(variantsOption).toInt(), config.imageCount);
+    config.samples = qMax(1, parser.value(samplesOption).toInt());
+    config.repeat = qMax(1, parser.value(repeatOption).toInt());
+    config.lookups = qMax(1, parser.value(lookupsOption).toInt());
+    config.label = parser.value(labelOption);
+    config.profile = parser.isSet(profileOption);
+
+    QTemporaryDir temporaryDir;
+    const QString workDir = parser.isSet(dirOption) ? parser.value(dirOption) : temporaryDir.path();
+    const QString sourceDir = workDir + "/source";
+    const QString exportDir = workDir + "/export";
+    const QString dbPath = workDir + "/ImageCollection.db";
+    QDir().mkpath(sourceDir);
+    QDir().mkpath(exportDir);
+    QFile::remove(dbPath);
+    QFile::remove(dbPath + "-wal");
+    QFile::remove(dbPath + "-shm");
+
+    QJsonObject results;
+    QElapsedTimer timer;
+
+    // 1. 生成源文件（不计入数据库耗时）
+    fprintf(stderr, "Generating %d source images...\n", config.variants);
+    QStringList sourceFiles;
+    qint64 sourceBytes = 0;
+    const QString suffix = config.imageFormat == "PNG" ? ".png" : ".jpg";
+    for (int i = 0; i < config.variants; ++i) {
+        const QString path = QString("%1/synthetic_%2%3").arg(sourceDir).arg(i, 4, 10, QChar('0')).arg(suffix);
+        if (!syntheticImage(config.imageSize, i).save(path, config.imageFormat.constData(), 90)) {
+            fprintf(stderr, "Failed to write %s\n", qPrintable(path));
+            return 1;
+        }
+        sourceFiles.append(path);
+        sourceBytes += QFileInfo(path).size();
+    }
+
+    Database *database = new Database();
+    if (!database->initialize(dbPath)) {
+        fprintf(stderr, "Failed to initialize database: %s\n", qPrintable(database->getLastError()));
+        delete database;
+        return 1;
+    }
+    if (config.profile) {
+        database->setQueryProfilingEnabled(true, 0);
+    }
+
+    // 2. 分组树：一条深层链 deep_1/deep_2/...，以及一个有 width 个子分组的宽层 wide/wide_N
+    timer.start();
+    QList<int> groupIds;
+    int deepRootId = -1;
+    int parentId = -1;
+    for (int level = 1; level <= config.depth; ++level) {
+        const QString name = QString("deep_%1").arg(level);
+        database->createGroup(name, parentId);
+        parentId = database->getGroupIdByName(name, parentId);
+        groupIds.append(parentId);
+        if (deepRootId < 0) {
+            deepRootId = parentId;
+        }
+    }
+    database->createGroup("wide");
+    const int wideRootId = database->getGroupIdByName("wide");
+    groupIds.append(wideRootId);
+    for (int i = 1; i <= config.width; ++i) {
+        const QString name = QString("wide_%1").arg(i);
+        database->createGroup(name, wideRootId);
+        groupIds.append(database->getGroupIdByName(name, wideRootId));
+    }
+    groupIds.append(-1); // 未分组
+    results.insert("createGroups", timing(timer.nsecsElapsed(), config.depth + config.width + 1));
+
+    // 3. 导入：图片按轮转分配到各分组，每个分组一次调用（并行准备 + 批量写入）
+    QHash<int, QList<QUrl>> filesByGroup;
+    qint64 importBytes = 0;
+    for (int i = 0; i < config.imageCount; ++i) {
+        const QString &path = sourceFiles.at(i % sourceFiles.size());
+        filesByGroup[groupIds.at(i % groupIds.size())].append(QUrl::fromLocalFile(path));
+        importBytes += QFileInfo(path).size();
+    }
+    fprintf(stderr, "Importing %d images...\n", config.imageCount);
+    timer.start();
+    int importedCount = 0;
+    for (int groupId : std::as_const(groupIds)) {
+        importedCount += database->insertImageFiles(filesByGroup.value(groupId), groupId);
+    }
+    {
+        const qint64 elapsed = timer.nsecsElapsed();
+        QJsonObject import = timing(elapsed, importedCount);
+        import.insert("mbPerSec", importBytes / (1024.0 * 1024.0) / (elapsed / 1e9));
+        results.insert("import", import);
+    }
+
+    // 4. 查询：全部图片ID、各分组图片ID、完整分组树
+    timer.start();
+    QList<int> allIds;
+    for (int i = 0; i < config.repeat; ++i) {
+        allIds = database->getAllImageIds(0);
+    }
+    results.insert("getAllImageIds", timing(timer.nsecsElapsed(), config.repeat));
+
+    timer.start();
+    for (int groupId : std::as_const(groupIds)) {
+        database->getAllImageIds(groupId);
+    }
+    results.insert("getAllImageIdsPerGroup", timing(timer.nsecsElapsed(), groupIds.size()));
+
+    timer.start();
+    for (int i = 0; i < config.repeat; ++i) {
+        database->getAllGroups();
+    }
+    results.insert("getAllGroups", timing(timer.nsecsElapsed(), config.repeat));
+
+    // 5. 读取：从全部图片中均匀抽样
+    QList<int> sampleIds;
+    const int sampleCount = qMin(config.samples, int(allIds.size()));
+    for (int i = 0; i < sampleCount; ++i) {
+        sampleIds.append(allIds.at(qint64(i) * allIds.size() / sampleCount));
+    }
+
+    auto fetchAll = [&](const char *name, bool useThumbnail, const QSize &targetSize) {
+        timer.start();
+        qint64 pixels = 0;
+        for (int id : std::as_const(sampleIds)) {
+            const QImage image = database->getImageAsQImage(id, useThumbnail, targetSize);
+            pixels += qint64(image.width()) * image.height();
+        }
+        QJsonObject result = timing(timer.nsecsElapsed(), sampleIds.size());
+        result.insert("decodedPixels", pixels);
+        results.insert(name, result);
+    };
+    fetchAll("thumbnailFetch", true, ThumbnailSize);
+    fetchAll("pyramidFetch", true, QSize(800, 800));
+    fetchAll("originalFetch", false, QSize());
+    fetchAll("originalFetchScaled", false, QSize(1280, 1280));
+
+    // 图片提供器的访问方式：多个工作线程同时读取，各自使用线程连接
+    timer.start();
+    QtConcurrent::blockingMap(sampleIds, [database](int id) {
+        database->getImageAsQImage(id, true, ThumbnailSize);
+    });
+    results.insert("thumbnailFetchParallel", timing(timer.nsecsElapsed(), sampleIds.size()));
+
+    // 6. 预编译语句缓存开启/关闭对比（同一组主键查询）
+    auto lookupAll = [&](bool cacheEnabled) {
+        database->setStatementCacheEnabled(cacheEnabled);
+        timer.start();
+        for (int i = 0; i < config.lookups; ++i) {
+            database->getImageFilename(allIds.at(i % allIds.size()));
+        }
+        return timer.nsecsElapsed();
+    };
+    lookupAll(true); // 预热
+    const qint64 cachedNsecs = lookupAll(true);
+    const qint64 uncachedNsecs = lookupAll(false);
+    database->setStatementCacheEnabled(true);
+    results.insert("lookupStatementCacheOn", timing(cachedNsecs, config.lookups));
+    results.insert("lookupStatementCacheOff", timing(uncachedNsecs, config.lookups));
+
+    // 7. 导出宽层子树：文件夹和 zip 归档
+    auto exportWide = [&](const char *name, int format) {
+        timer.start();
+        waitForSignal(database, &Database::exportFinished, [&]() {
+            database->startAsyncExport(wideRootId, "wide", exportDir, true, format, false);
+        });
+        const qint64 elapsed = timer.nsecsElapsed();
+        results.insert(name, timing(elapsed, database->getImageCountForGroup(wideRootId)));
+    };
+    fprintf(stderr, "Exporting...\n");
+    exportWide("exportFolder", Database::ExportToFolder);
+    exportWide("exportZip", Database::ExportToZip);
+
+    // 8. 删除：整条深层链（级联删除子分组和图片）
+    const int deepImageCount = database->getImageCountForGroup(deepRootId);
+    timer.start();
+    const bool deleted = database->deleteGroup(deepRootId);
+    {
+        QJsonObject result = timing(timer.nsecsElapsed(), deepImageCount);
+        result.insert("groups", config.depth);
+        result.insert("success", deleted);
+        results.insert("deleteGroup", result);
+    }
+
+    QJsonObject configJson;
+    configJson.insert("images", config.imageCount);
+    configJson.insert("depth", config.depth);
+    configJson.insert("width", config.width);
+    configJson.insert("imageWidth", config.imageSize.width());
+    configJson.insert("imageHeight", config.imageSize.height());
+    configJson.insert("format", QString::fromLatin1(config.imageFormat));
+    configJson.insert("variants", config.variants);
+    configJson.insert("sourceBytes", sourceBytes);
+    configJson.insert("samples", sampleIds.size());
+    configJson.insert("repeat", config.repeat);
+    configJson.insert("lookups", config.lookups);
+    configJson.insert("profile", config.profile);
+
+    QJsonObject environment;
+    environment.insert("qt", QString::fromLatin1(qVersion()));
+    {
+        QSqlQuery query;
+        if (query.exec("SELECT sqlite_version()") && query.next()) {
+            environment.insert("sqlite", query.value(0).toString());
+        }
+    }
+    environment.insert("threads", QThread::idealThreadCount());
+
+    QJsonObject output;
+    if (!config.label.isEmpty()) {
+        output.insert("label", config.label);
+    }
+    output.insert("config", configJson);
+    output.insert("environment", environment);
+    output.insert("results", results);
+    output.insert("storage", QJsonObject::fromVariantMap(database->getStorageStatus()));
+    output.insert("wal", QJsonObject::fromVariantMap(database->getWalStatus()));
+    if (config.profile) {
+        output.insert("queryProfile", QJsonArray::fromVariantList(database->getQueryProfile()));
+    }
+
+    delete database;
+
+    fprintf(stdout, "%s\n", QJsonDocument(output).toJson(QJsonDocument::Indented).constData());
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "blobreaddevice.h"
+#include "queryprofiler.h"
+#include <QElapsedTimer>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <cstring>
+
+#ifdef IMAGEDB_SQLITE_BLOB_IO
+#include <sqlite3.h>
+#endif
+
+BlobReadDevice::BlobReadDevice(const QSqlDatabase &db, const QString &table, const QString &column,
+                               qint64 rowId, QObject *parent)
+    : QIODevice(parent),
+      m_db(db),
+      m_table(table),
+      m_column(column),
+      m_rowId(rowId),
+      m_blob(nullptr),
+      m_size(0),
+      m_profiler(nullptr),
+      m_caller(nullptr),
+      m_elapsedNs(0),
+      m_bytesRead(0)
+{
+}
+
+BlobReadDevice::~BlobReadDevice()
+{
+    close();
+}
+
+void BlobReadDevice::setProfiler(QueryProfiler *profiler, const char *caller)
+{
+    m_profiler = profiler;
+    m_caller = caller;
+}
+
+bool BlobReadDevice::open(OpenMode mode)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const bool opened = openBlob(mode);
+    m_elapsedNs += timer.nsecsElapsed();
+    return opened;
+}
+
+bool BlobReadDevice::openBlob(OpenMode mode)
+{
+    if (mode & WriteOnly) {
+        m_errorText = "BlobReadDevice is read-only";
+        return false;
+    }
+
+#ifdef IMAGEDB_SQLITE_BLOB_IO
+    // 从Qt驱动取得底层 sqlite3 连接句柄，打开增量 BLOB 句柄
+    QVariant handle = m_db.driver() ? m_db.driver()->handle() : QVariant();
+    if (handle.isValid() && qstrcmp(handle.typeName(), "sqlite3*") == 0) {
+        sqlite3 *connection = *static_cast<sqlite3 **>(handle.data());
+        if (connection) {
+            int rc = sqlite3_blob_open(connection, "main",
+                                       m_table.toUtf8().constData(), m_column.toUtf8().constData(),
+                                       m_rowId, 0, &m_blob);
+            if (rc != SQLITE_OK) {
+                m_errorText = QString::fromUtf8(sqlite3_errmsg(connection));
+                if (m_blob) {
+                    sqlite3_blob_close(m_blob);
+                    m_blob = nullptr;
+                }
+                return false;
+            }
+            m_size = sqlite3_blob_bytes(m_blob);
+            // 设备本身不再做缓冲，每次读取直接落到调用者的缓冲区
+            return QIODevice::open(ReadOnly | Unbuffered);
+        }
+    }
+#endif
+
+    // 回退：一次性读取整个BLOB
+    QSqlQuery query(m_db);
+    query.prepare(QString("SELECT %1 FROM %2 WHERE rowid = ?").arg(m_column, m_table));
+    query.addBindValue(m_rowId);
+    if (!query.exec() || !query.next()) {
+        m_errorText = query.lastError().isValid() ? query.lastError().text() : QString("Row %1 not found").arg(m_rowId);
+        return false;
+    }
+    m_buffer = query.value(0).toByteArray();
+    m_size = m_buffer.size();
+    return QIODevice::open(ReadOnly | Unbuffered);
+}
+
+void BlobReadDevice::close()
+{
+    if (m_profiler && isOpen()) {
+        m_profiler->record(QString("BLOB %1.%2").arg(m_table, m_column), m_caller, m_elapsedNs, 1, m_bytesRead);
+    }
+    m_elapsedNs = 0;
+    m_bytesRead = 0;
+
+#ifdef IMAGEDB_SQLITE_BLOB_IO
+    if (m_blob) {
+        sqlite3_blob_close(m_blob);
+        m_blob = nullptr;
+    }
+#endif
+    m_buffer.clear();
+    m_size = 0;
+    QIODevice::close();
+}
+
+bool BlobReadDevice::isStreaming() const
+{
+    return m_blob != nullptr;
+}
+
+qint64 BlobReadDevice::size() const
+{
+    return m_size;
+}
+
+qint64 BlobReadDevice::readData(char *data, qint64 maxSize)
+{
+    if (!m_profiler) {
+        return readBlob(data, maxSize);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 bytesRead = readBlob(data, maxSize);
+    m_elapsedNs += timer.nsecsElapsed();
+    m_bytesRead += qMax<qint64>(0, bytesRead);
+    return bytesRead;
+}
+
+qint64 BlobReadDevice::readBlob(char *data, qint64 maxSize)
+{
+    const qint64 offset = pos();
+    const qint64 bytesToRead = qMin(maxSize, m_size - offset);
+    if (bytesToRead <= 0) {
+        return 0;
+    }
+
+#ifdef IMAGEDB_SQLITE_BLOB_IO
+    if (m_blob) {
+        if (sqlite3_blob_read(m_blob, data, int(bytesToRead), int(offset)) != SQLITE_OK) {
+            setErrorString("sqlite3_blob_read failed");
+            return -1;
+        }
+        return bytesToRead;
+    }
+#endif
+
+    std::memcpy(data, m_buffer.constData() + offset, size_t(bytesToRead));
+    return bytesToRead;
+}
+
+qint64 BlobReadDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
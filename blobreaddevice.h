@@ -0,0 +1,69 @@
+/**
+ * @file blobreaddevice.h
+ * @brief 数据库 BLOB 读取设备
+ *
+ * 以 QIODevice 的形式读取 SQLite 中的 BLOB 列，供 QImageReader 解码和导出写文件直接使用。
+ *
+ * 默认实现打开时一次性读取整个 BLOB（内存占用与图片大小相同），Windows 发布版即使用此实现：
+ * 官方 Qt 的 QSQLITE 插件内置 SQLite 且不导出其函数，无法对驱动的连接做增量读取。
+ * 只有 Qt 以 -system-sqlite 构建、并开启 IMAGEDB_SQLITE_BLOB_IO 链接同一份 SQLite 时，
+ * 才使用 sqlite3 增量 BLOB 句柄（sqlite3_blob_read）按块读取，接口保持一致。
+ * 设置 QueryProfiler 后，打开和读取的总耗时及读取字节数在关闭时记为一次执行。
+ */
+
+#ifndef BLOBREADDEVICE_H
+#define BLOBREADDEVICE_H
+
+#include <QIODevice>
+#include <QSqlDatabase>
+#include <QByteArray>
+
+struct sqlite3_blob;
+class QueryProfiler;
+
+class BlobReadDevice : public QIODevice
+{
+public:
+    BlobReadDevice(const QSqlDatabase &db, const QString &table, const QString &column,
+                   qint64 rowId, QObject *parent = nullptr);
+    ~BlobReadDevice();
+
+    // 只支持只读方式打开
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return false; }
+    qint64 size() const override;
+
+    QString errorText() const { return m_errorText; }
+
+    // 开启查询统计（需在 open() 之前调用），caller 为发起读取的方法名（静态字符串）
+    void setProfiler(QueryProfiler *profiler, const char *caller);
+
+    // 打开后是否使用增量 BLOB 句柄；未开启 IMAGEDB_SQLITE_BLOB_IO 时始终为 false
+    bool isStreaming() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    bool openBlob(OpenMode mode);
+    qint64 readBlob(char *data, qint64 maxSize);
+
+    QSqlDatabase m_db;
+    QString m_table;
+    QString m_column;
+    qint64 m_rowId;
+    sqlite3_blob *m_blob; // 增量 BLOB 句柄（仅 IMAGEDB_SQLITE_BLOB_IO）
+    QByteArray m_buffer;  // 回退实现使用的完整数据
+    qint64 m_size;
+    QString m_errorText;
+
+    // 查询统计（m_profiler 为空时不记录）
+    QueryProfiler *m_profiler;
+    const char *m_caller;
+    qint64 m_elapsedNs;
+    qint64 m_bytesRead;
+};
+
+#endif // BLOBREADDEVICE_H
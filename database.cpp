@@ -1,62 +1,237 @@
 #include "database.h"
+#include "blobreaddevice.h"
+#include "archivewriter.h"
 #include <QCoreApplication>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QBuffer>
+#include <QFile>
 #include <QFileInfo>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QImage>
 #include <QByteArray>
 #include <QString>
+#include <QQueue>
+#include <QCryptographicHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QHash>
+#include <QImageReader>
+#include <iterator>
+#include <utility>
+
+class PooledConnection;
+
+// 尚未释放的工作线程连接。由 Database 和各连接共同持有：
+// 线程先退出时由 QThreadStorage 销毁连接；Database 先销毁时统一释放仍存活的连接
+// （QThreadStorage 先于线程销毁时不再删除线程数据）
+struct PooledConnectionRegistry
+{
+    QMutex mutex;
+    QSet<PooledConnection *> connections;
+};
+
+// 工作线程独占的数据库连接
+class PooledConnection
+{
+public:
+    PooledConnection(const QString &name, const std::shared_ptr<PooledConnectionRegistry> &registry)
+        : m_name(name),
+          m_registry(registry)
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        m_registry->connections.insert(this);
+    }
+
+    ~PooledConnection()
+    {
+        QMutexLocker locker(&m_registry->mutex);
+        if (m_registry->connections.remove(this)) {
+            release();
+        }
+    }
+
+    // 释放语句并移除连接（持有 registry 锁时调用，只执行一次）
+    void release()
+    {
+        // 语句必须在连接关闭前释放；连接可能属于其他线程，不通过 QSqlDatabase::database() 取回，
+        // 移除时最后一个引用释放并关闭连接
+        m_statements.clear();
+        QSqlDatabase::removeDatabase(m_name);
+    }
+
+    QString name() const { return m_name; }
+    StatementCache &statements() { return m_statements; }
+
+private:
+    QString m_name;
+    StatementCache m_statements;
+    std::shared_ptr<PooledConnectionRegistry> m_registry;
+};
+
+// user_settings 中记录"下次启动时重建数据库"的键
+static const char *StorageRebuildSettingKey = "storage_rebuild_pending";
+
+// 批量写入期间把连接的同步级别降为 NORMAL：提交时不再 fsync WAL，由检查点统一刷盘，
+// 断电时最多丢失最近几批（数据库不会损坏）；离开作用域时恢复交互写入使用的 FULL。
+// 必须在事务之外创建和销毁
+class BulkWriteScope
+{
+public:
+    BulkWriteScope(const QSqlDatabase &db, std::atomic<int> &activeCount)
+        : m_db(db),
+          m_activeCount(activeCount)
+    {
+        QSqlQuery query(m_db);
+        if (!query.exec("PRAGMA synchronous = NORMAL")) {
+            qWarning() << "Failed to relax synchronous for bulk writes:" << query.lastError().text();
+        }
+        m_activeCount++;
+    }
+
+    ~BulkWriteScope()
+    {
+        m_activeCount--;
+        QSqlQuery query(m_db);
+        if (!query.exec("PRAGMA synchronous = FULL")) {
+            qWarning() << "Failed to restore synchronous after bulk writes:" << query.lastError().text();
+        }
+    }
+
+    BulkWriteScope(const BulkWriteScope &) = delete;
+    BulkWriteScope &operator=(const BulkWriteScope &) = delete;
+
+private:
+    QSqlDatabase m_db;
+    std::atomic<int> &m_activeCount;
+};
+
+// 保持比例缩小到 bound 以内的尺寸；bound 某一维 <= 0 表示该维不限制，不会放大
+static QSize boundedSize(const QSize &source, const QSize &bound)
+{
+    QSize box(bound.width() > 0 ? bound.width() : source.width(),
+              bound.height() > 0 ? bound.height() : source.height());
+    if (source.width() <= box.width() && source.height() <= box.height()) {
+        return source;
+    }
+    return source.scaled(box, Qt::KeepAspectRatio);
+}
 
 Database::Database(QObject *parent)
     : QObject(parent),
+      m_pooledConnections(std::make_shared<PooledConnectionRegistry>()),
+      m_statementCacheEnabled(true),
+      m_queryProfilingEnabled(false),
+      m_queryProfileTimer(nullptr),
       m_importWatcher(nullptr),
+      m_importPool(nullptr),
       m_importCurrentIndex(0),
       m_importTotalCount(0),
       m_importSuccessCount(0),
+      m_importDuplicateCount(0),
       m_importCancelled(false),
       m_exportWatcher(nullptr),
-      m_exportCurrentIndex(0),
+      m_exportPool(nullptr),
       m_exportTotalCount(0),
       m_exportSuccessCount(0),
-      m_exportCancelled(false)
+      m_exportCancelled(false),
+      m_shuttingDown(false),
+      m_maintenancePool(nullptr),
+      m_maintenanceTimer(nullptr),
+      m_lastWalBytes(-1),
+      m_maintenanceRunning(false),
+      m_bulkWriters(0),
+      m_storageMaintenanceRequested(true)
 {
     // 初始化异步导入相关成员
     m_importWatcher = new QFutureWatcher<bool>(this);
     connect(m_importWatcher, &QFutureWatcher<bool>::finished, this, &Database::onImportFinished);
+
+    // 解码和缩略图生成的工作线程数与CPU核心数一致
+    m_importPool = new QThreadPool(this);
+    m_importPool->setMaxThreadCount(QThread::idealThreadCount());
     
     // 初始化异步导出相关成员
     m_exportWatcher = new QFutureWatcher<bool>(this);
     connect(m_exportWatcher, &QFutureWatcher<bool>::finished, this, &Database::onExportFinished);
+
+    // 导出的瓶颈是磁盘写入和BLOB读取，少量并行写入即可让磁盘保持忙碌
+    m_exportPool = new QThreadPool(this);
+    m_exportPool->setMaxThreadCount(qBound(2, QThread::idealThreadCount(), int(MaxExportWriters)));
+
+    // 检查点等维护任务在单独的线程中串行执行，不占用界面线程和导入导出线程
+    m_maintenancePool = new QThreadPool(this);
+    m_maintenancePool->setMaxThreadCount(1);
+
+    // 数据库打开后开始定时检查 WAL
+    m_maintenanceTimer = new QTimer(this);
+    m_maintenanceTimer->setInterval(CheckpointPollIntervalMs);
+    connect(m_maintenanceTimer, &QTimer::timeout, this, &Database::onMaintenanceTimer);
+
+    // 查询统计的定期日志（开启统计后启动）
+    m_queryProfileTimer = new QTimer(this);
+    connect(m_queryProfileTimer, &QTimer::timeout, this, &Database::onQueryProfileDump);
 }
 
 Database::~Database()
 {
-    if (m_db.isOpen()) {
-        m_db.close();
-    }
-    
-    // 清理异步导入资源
+    // 先停止所有后台任务，关闭连接时不能再有写入在进行
+    // 取消导入和导出，等待写入线程结束
     if (m_importWatcher) {
         cancelAsyncImport();
-        m_importWatcher->deleteLater();
     }
-    
-    // 清理异步导出资源
     if (m_exportWatcher) {
         cancelAsyncExport();
-        m_exportWatcher->deleteLater();
+    }
+    m_importPool->waitForDone();
+    m_exportPool->waitForDone();
+
+    // 等待后台迁移在当前批次结束后退出
+    m_shuttingDown = true;
+    m_migrationFuture.waitForFinished();
+
+    // 等待正在执行的检查点
+    m_maintenanceTimer->stop();
+    m_maintenancePool->waitForDone();
+
+    // 释放工作线程的连接：全局线程池等线程在 Database 之后才退出，不能依赖线程退出时释放
+    {
+        QMutexLocker locker(&m_pooledConnections->mutex);
+        for (PooledConnection *connection : std::as_const(m_pooledConnections->connections)) {
+            connection->release();
+        }
+        m_pooledConnections->connections.clear();
+    }
+
+    m_statementCache.clear();
+    if (m_db.isOpen()) {
+        // 关闭前按需更新查询统计信息（只分析统计信息过期的表，通常很快）
+        {
+            QSqlQuery query(m_db);
+            query.exec(QString("PRAGMA analysis_limit = %1").arg(AnalysisLimit));
+            query.exec("PRAGMA optimize");
+        }
+        m_db.close();
     }
 }
 
 bool Database::initialize()
 {
-    m_db = QSqlDatabase::addDatabase("QSQLITE");
-    
     // 获取应用程序所在目录，将数据库文件保存在应用程序目录下
     QString appDir = QCoreApplication::applicationDirPath();
-    QString dbPath = appDir + "/ImageCollection.db";
+    return initialize(appDir + "/ImageCollection.db");
+}
+
+bool Database::initialize(const QString &dbPath)
+{
+    m_db = QSqlDatabase::addDatabase("QSQLITE");
     m_db.setDatabaseName(dbPath);
 
     if (!m_db.open()) {
@@ -64,50 +239,48 @@ bool Database::initialize()
         return false;
     }
 
-    // 开启外键约束和性能优化设置
-    QSqlQuery query;
-    
-    // 设置外键约束
-    if (!query.exec("PRAGMA foreign_keys = ON")) {
-        m_lastError = query.lastError().text();
-        return false;
-    }
-    
-    // 设置缓存大小为30000页
-    if (!query.exec("PRAGMA cache_size = 30000")) {
-        m_lastError = query.lastError().text();
+    // 开启外键约束和性能优化设置（每个连接都需要单独设置）
+    if (!applyConnectionPragmas(m_db, 30000, &m_lastError)) {
         return false;
     }
+
+    QSqlQuery query;
     
-    // 使用内存作为临时存储
-    if (!query.exec("PRAGMA temp_store = MEMORY")) {
+    // 设置页面大小为8192字节（只对新建的数据库生效，已有数据库通过 requestStorageRebuild 重建后迁移）
+    if (!query.exec(QString("PRAGMA page_size = %1").arg(DatabasePageSize))) {
         m_lastError = query.lastError().text();
         return false;
     }
     
-    // 设置页面大小为8192字节
-    if (!query.exec("PRAGMA page_size = 8192")) {
+    // 设置自动清理模式为增量模式（同上，空闲页由后台整理逐步释放）
+    if (!query.exec("PRAGMA auto_vacuum = INCREMENTAL")) {
         m_lastError = query.lastError().text();
         return false;
     }
-    
-    // 设置内存映射大小为512MB（适合千张以上图片的大数据库场景）
-    if (!query.exec("PRAGMA mmap_size = 536870912")) {
+
+    // 使用WAL日志模式：读连接不会被写入阻塞，后台线程的读写可以与界面读取并发进行
+    if (!query.exec("PRAGMA journal_mode = WAL")) {
         m_lastError = query.lastError().text();
         return false;
     }
-    
-    // 设置自动清理模式为增量模式
-    if (!query.exec("PRAGMA auto_vacuum = INCREMENTAL")) {
-        m_lastError = query.lastError().text();
-        return false;
+    if (!query.next() || query.value(0).toString().compare("wal", Qt::CaseInsensitive) != 0) {
+        qWarning() << "WAL journal mode is not available, falling back to the default journal";
     }
+    query.finish();
+
+    // 检查点调度按 WAL 文件大小判断是否需要执行
+    m_walPath = dbPath + "-wal";
 
     // 创建分组表
     if (!createGroupsTable()) {
         return false;
     }
 
+    // 创建分组层级闭包表（子孙/祖先查询使用索引，不再递归）
+    if (!createGroupClosureTable()) {
+        return false;
+    }
+
     // 创建图片表
     QString createImagesTable = R"(
         CREATE TABLE IF NOT EXISTS images (
@@ -139,6 +312,26 @@ bool Database::initialize()
         return false;
     }
 
+    // 创建内容哈希表（用于导入去重）
+    if (!createImageHashesTable()) {
+        return false;
+    }
+
+    // 创建缩略图和元数据窄表
+    if (!createImageSideTables()) {
+        return false;
+    }
+
+    // 创建多分辨率缩略图表
+    if (!createImagePyramidTable()) {
+        return false;
+    }
+
+    // 创建分组统计表（图片数量和字节数由触发器维护）
+    if (!createGroupStatsTable()) {
+        return false;
+    }
+
     // 创建user_settings表
     QString createUserSettingsTable = R"(
         CREATE TABLE IF NOT EXISTS user_settings (
@@ -153,6 +346,20 @@ bool Database::initialize()
         return false;
     }
 
+    // 用户安排的重建在其他连接打开之前执行；只尝试一次，失败时不会在每次启动时重试
+    if (getSetting(StorageRebuildSettingKey) == "1") {
+        saveSetting(StorageRebuildSettingKey, "0");
+        if (!rebuildStorage()) {
+            qWarning() << "Database rebuild failed:" << m_lastError;
+        }
+    }
+
+    // 旧数据库在后台迁移缩略图和元数据、补生成多分辨率缩略图和尺寸信息，不阻塞启动
+    startBackgroundMigrations();
+
+    // 检查点改由后台调度执行
+    m_maintenanceTimer->start();
+
     return true;
 }
 
@@ -177,159 +384,144 @@ bool Database::createGroupsTable()
     return true;
 }
 
-// 用户设置相关方法实现
-
-// 保存单个设置
-bool Database::saveSetting(const QString &key, const QString &value)
+bool Database::createGroupClosureTable()
 {
+    // 闭包表：每对（祖先, 子孙）一行，depth 为层级差，每个分组与自身构成 depth = 0 的一行。
+    // 由触发器维护，应用中所有创建和移动分组的路径（包括导入时自动建组）都会自动保持一致；
+    // 删除分组时通过外键级联删除对应的行
     QSqlQuery query;
-    
-    // 使用UPSERT语法（SQLite 3.24.0+支持）
-    QString sql = R"(
-        INSERT INTO user_settings (setting_key, setting_value, updated_time)
-        VALUES (:key, :value, CURRENT_TIMESTAMP)
-        ON CONFLICT(setting_key) DO UPDATE SET
-            setting_value = :value,
-            updated_time = CURRENT_TIMESTAMP
+    QString createClosureTable = R"(
+        CREATE TABLE IF NOT EXISTS group_closure (
+            ancestor_id INTEGER NOT NULL,
+            descendant_id INTEGER NOT NULL,
+            depth INTEGER NOT NULL,
+            PRIMARY KEY (ancestor_id, descendant_id),
+            FOREIGN KEY (ancestor_id) REFERENCES groups(id) ON DELETE CASCADE,
+            FOREIGN KEY (descendant_id) REFERENCES groups(id) ON DELETE CASCADE
+        ) WITHOUT ROWID
     )";
-    
-    query.prepare(sql);
-    query.bindValue(":key", key);
-    query.bindValue(":value", value);
-    
-    if (!query.exec()) {
+
+    if (!query.exec(createClosureTable)) {
         m_lastError = query.lastError().text();
         return false;
     }
-    
-    return true;
-}
 
-// 获取单个设置
-QString Database::getSetting(const QString &key, const QString &defaultValue)
-{
-    QSqlQuery query;
-    
-    QString sql = "SELECT setting_value FROM user_settings WHERE setting_key = :key";
-    query.prepare(sql);
-    query.bindValue(":key", key);
-    
-    if (!query.exec()) {
+    // 祖先查询（分组路径）和外键级联删除按 descendant_id 查找
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_group_closure_descendant ON group_closure(descendant_id, depth)")) {
         m_lastError = query.lastError().text();
-        return defaultValue;
-    }
-    
-    if (query.next()) {
-        return query.value(0).toString();
+        return false;
     }
-    
-    return defaultValue;
-}
 
-// 获取所有设置
-QVariantMap Database::getAllSettings()
-{
-    QVariantMap settings;
-    QSqlQuery query;
-    
-    QString sql = "SELECT setting_key, setting_value FROM user_settings";
-    if (!query.exec(sql)) {
+    // 新建分组：继承父分组的所有祖先，再加上自身
+    QString insertTrigger = R"(
+        CREATE TRIGGER IF NOT EXISTS trg_groups_closure_insert
+        AFTER INSERT ON groups
+        BEGIN
+            INSERT INTO group_closure (ancestor_id, descendant_id, depth)
+            SELECT ancestor_id, NEW.id, depth + 1 FROM group_closure WHERE descendant_id = NEW.parent_id
+            UNION ALL
+            SELECT NEW.id, NEW.id, 0;
+        END
+    )";
+
+    if (!query.exec(insertTrigger)) {
         m_lastError = query.lastError().text();
-        return settings;
+        return false;
     }
-    
-    while (query.next()) {
-        QString key = query.value(0).toString();
-        QString value = query.value(1).toString();
-        settings.insert(key, value);
+
+    // 移动分组：先断开整个子树与原祖先的联系，再把子树接到新父分组的所有祖先下
+    QString moveTrigger = R"(
+        CREATE TRIGGER IF NOT EXISTS trg_groups_closure_move
+        AFTER UPDATE OF parent_id ON groups
+        WHEN OLD.parent_id IS NOT NEW.parent_id
+        BEGIN
+            DELETE FROM group_closure
+            WHERE descendant_id IN (SELECT descendant_id FROM group_closure WHERE ancestor_id = NEW.id)
+              AND ancestor_id NOT IN (SELECT descendant_id FROM group_closure WHERE ancestor_id = NEW.id);
+
+            INSERT INTO group_closure (ancestor_id, descendant_id, depth)
+            SELECT super.ancestor_id, sub.descendant_id, super.depth + sub.depth + 1
+            FROM group_closure super
+            JOIN group_closure sub ON sub.ancestor_id = NEW.id
+            WHERE super.descendant_id = NEW.parent_id;
+        END
+    )";
+
+    if (!query.exec(moveTrigger)) {
+        m_lastError = query.lastError().text();
+        return false;
     }
-    
-    return settings;
-}
 
-bool Database::insertImage(const QString &fileName, int groupId)
-{
-    // 正常导入单个图片
-    QImage image(fileName);
-    if (image.isNull()) {
-        m_lastError = "Failed to load image: " + fileName;
+    // 旧数据库首次升级，或闭包表与分组表不一致时重建（每个分组都应有一行 depth = 0）
+    if (!query.exec(R"(
+        SELECT (SELECT COUNT(*) FROM groups) = (SELECT COUNT(*) FROM group_closure WHERE depth = 0)
+    )") || !query.next()) {
+        m_lastError = query.lastError().text();
         return false;
     }
-    
-    return insertImage(fileName, image, groupId);
+    const bool consistent = query.value(0).toBool();
+    query.finish();
+
+    if (!consistent) {
+        return rebuildGroupClosure();
+    }
+
+    return true;
 }
 
-bool Database::insertImage(const QUrl &fileUrl, int groupId)
+bool Database::rebuildGroupClosure()
 {
-    // 处理URL类型的文件路径
-    QString fileName = fileUrl.toLocalFile();
-    if (fileName.isEmpty()) {
-        m_lastError = "Invalid file URL: " + fileUrl.toString();
+    if (!m_db.transaction()) {
+        m_lastError = m_db.lastError().text();
         return false;
     }
-    
-    return insertImage(fileName, groupId);
-}
 
-bool Database::insertImage(const QString &fileName, const QImage &image, int groupId)
-{
-    // 1. 获取原始图片格式
-    QString fileExtension = QFileInfo(fileName).suffix().toUpper();
-    QString imageFormat = "JPG"; // 默认格式
+    QSqlQuery query;
+    QString rebuildQuery = R"(
+        INSERT INTO group_closure (ancestor_id, descendant_id, depth)
+        WITH RECURSIVE paths(ancestor_id, descendant_id, depth) AS (
+            SELECT id, id, 0 FROM groups
+            UNION ALL
+            SELECT p.ancestor_id, g.id, p.depth + 1
+            FROM paths p JOIN groups g ON g.parent_id = p.descendant_id
+        )
+        SELECT ancestor_id, descendant_id, depth FROM paths
+    )";
 
-    // 根据文件扩展名设置图片格式
-    if (fileExtension == "PNG") {
-        imageFormat = "PNG";
-    } else if (fileExtension == "BMP") {
-        imageFormat = "BMP";
-    } else if (fileExtension == "GIF") {
-        imageFormat = "GIF";
-    } else if (fileExtension == "JPG" || fileExtension == "JPEG") {
-        imageFormat = "JPG";
-    } else if (fileExtension == "WEBP") {
-        imageFormat = "WEBP";
+    if (!query.exec("DELETE FROM group_closure") || !query.exec(rebuildQuery)) {
+        m_lastError = query.lastError().text();
+        m_db.rollback();
+        return false;
     }
 
-    // 2. 直接从文件读取原始图片数据，避免重新编码导致的质量损失和性能问题
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
-        m_lastError = "Failed to open file: " + fileName;
+    if (!m_db.commit()) {
+        m_lastError = m_db.lastError().text();
+        m_db.rollback();
         return false;
     }
-    QByteArray byteArray = file.readAll();
-    file.close();
-
-    // 3. 生成缩略图（宽度固定为140px，高度自适应，保持比例）
-    QImage thumbnail = image.scaled(
-        140, // 固定宽度
-        140 * 1.5, // 最大高度210px
-        Qt::KeepAspectRatio, // 保持比例
-        Qt::FastTransformation // 快速缩放，缩略图不需要平滑算法，提高生成速度
-    );
 
-    QByteArray thumbnailData;
-    QBuffer thumbnailBuffer(&thumbnailData);
-    thumbnailBuffer.open(QIODevice::WriteOnly);
-    thumbnail.save(&thumbnailBuffer, "JPG", 85); // 缩略图统一使用JPG格式，质量85
+    qDebug() << "Group closure table rebuilt";
+    return true;
+}
 
-    // 4. 准备SQL语句并添加绑定值
+bool Database::createImageHashesTable()
+{
+    // 内容哈希单独存放在窄表中：写入和补算哈希时不需要重写带有大BLOB的images行
     QSqlQuery query;
-    if (groupId > 0) {
-        query.prepare("INSERT INTO images (filename, image_data, image_format, thumbnail, group_id) VALUES (?, ?, ?, ?, ?)");
-        query.addBindValue(QFileInfo(fileName).fileName());
-        query.addBindValue(byteArray);
-        query.addBindValue(imageFormat);
-        query.addBindValue(thumbnailData);
-        query.addBindValue(groupId);
-    } else {
-        query.prepare("INSERT INTO images (filename, image_data, image_format, thumbnail) VALUES (?, ?, ?, ?)");
-        query.addBindValue(QFileInfo(fileName).fileName());
-        query.addBindValue(byteArray);
-        query.addBindValue(imageFormat);
-        query.addBindValue(thumbnailData);
+    QString createHashesTable = R"(
+        CREATE TABLE IF NOT EXISTS image_hashes (
+            image_id INTEGER PRIMARY KEY,
+            content_hash BLOB NOT NULL,
+            FOREIGN KEY (image_id) REFERENCES images(id) ON DELETE CASCADE
+        )
+    )";
+
+    if (!query.exec(createHashesTable)) {
+        m_lastError = query.lastError().text();
+        return false;
     }
 
-    if (!query.exec()) {
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_image_hashes_content_hash ON image_hashes(content_hash)")) {
         m_lastError = query.lastError().text();
         return false;
     }
@@ -337,752 +529,3011 @@ bool Database::insertImage(const QString &fileName, const QImage &image, int gro
     return true;
 }
 
-QString Database::getImageFilename(int id)
+bool Database::createImageSideTables()
 {
+    // images 表中 thumbnail 等列位于数MB的 image_data 之后，读取它们需要沿原图的溢出页链表逐页查找。
+    // 缩略图和元数据单独存放，读取延迟与原图大小无关
     QSqlQuery query;
-    query.prepare("SELECT filename FROM images WHERE id = ?");
-    query.addBindValue(id);
-    
-    if (!query.exec() || !query.next()) {
+    QString createThumbnailsTable = R"(
+        CREATE TABLE IF NOT EXISTS image_thumbnails (
+            image_id INTEGER PRIMARY KEY,
+            thumbnail BLOB NOT NULL,
+            FOREIGN KEY (image_id) REFERENCES images(id) ON DELETE CASCADE
+        )
+    )";
+
+    if (!query.exec(createThumbnailsTable)) {
         m_lastError = query.lastError().text();
-        return QString();
+        return false;
     }
-    
-    return query.value(0).toString();
-}
 
-QList<int> Database::getAllImageIds(int groupId)
-{
-    QList<int> ids;
-    QSqlQuery query;
-    
-    if (groupId > 0) {
-        // 返回指定分组的图片
-        query.prepare("SELECT id FROM images WHERE group_id = ? ORDER BY id");
-        query.addBindValue(groupId);
-    } else if (groupId == -1) {
-        // 返回未分组的图片（group_id为NULL或-1）
-        query.prepare("SELECT id FROM images WHERE group_id IS NULL OR group_id = -1 ORDER BY id");
-    } else {
-        // 返回所有图片（如果需要的话）
-        query.prepare("SELECT id FROM images ORDER BY id");
+    QString createMetaTable = R"(
+        CREATE TABLE IF NOT EXISTS image_meta (
+            image_id INTEGER PRIMARY KEY,
+            image_format TEXT NOT NULL DEFAULT 'JPG',
+            byte_size INTEGER NOT NULL DEFAULT 0,
+            width INTEGER,
+            height INTEGER,
+            pixel_format INTEGER,
+            color_depth INTEGER,
+            FOREIGN KEY (image_id) REFERENCES images(id) ON DELETE CASCADE
+        )
+    )";
+
+    if (!query.exec(createMetaTable)) {
+        m_lastError = query.lastError().text();
+        return false;
     }
-    
-    if (!query.exec()) {
+
+    // 旧版本创建的 image_meta 没有尺寸和像素格式列，补上后由后台任务填充（NULL 表示尚未读取）
+    QSet<QString> metaColumns;
+    if (!query.exec("PRAGMA table_info(image_meta)")) {
         m_lastError = query.lastError().text();
-        return ids;
+        return false;
     }
-    
     while (query.next()) {
-        ids.append(query.value(0).toInt());
+        metaColumns.insert(query.value(1).toString());
     }
-    
-    return ids;
-}
+    query.finish();
 
-// 分组相关方法实现
-bool Database::createGroup(const QString &name, int parentId)
+    const QList<QPair<QString, QString>> addedColumns = {
+        { "width", "INTEGER" },
+        { "height", "INTEGER" },
+        { "pixel_format", "INTEGER" },
+        { "color_depth", "INTEGER" }
+    };
+    for (const auto &column : addedColumns) {
+        if (metaColumns.contains(column.first)) {
+            continue;
+        }
+        if (!query.exec(QString("ALTER TABLE image_meta ADD COLUMN %1 %2").arg(column.first, column.second))) {
+            m_lastError = query.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Database::createImagePyramidTable()
 {
+    // 每张图片按长边保存若干级预编码的缩略图，列表放大或高DPI屏幕时无需解码原图
     QSqlQuery query;
-    
-    if (parentId > 0) {
-        query.prepare("INSERT INTO groups (name, parent_id) VALUES (?, ?)");
-        query.addBindValue(name);
-        query.addBindValue(parentId);
-    } else {
-        query.prepare("INSERT INTO groups (name) VALUES (?)");
-        query.addBindValue(name);
-    }
-    
-    if (!query.exec()) {
+    QString createPyramidTable = R"(
+        CREATE TABLE IF NOT EXISTS image_pyramid (
+            image_id INTEGER NOT NULL,
+            max_edge INTEGER NOT NULL,
+            data BLOB NOT NULL,
+            PRIMARY KEY (image_id, max_edge),
+            FOREIGN KEY (image_id) REFERENCES images(id) ON DELETE CASCADE
+        ) WITHOUT ROWID
+    )";
+
+    if (!query.exec(createPyramidTable)) {
         m_lastError = query.lastError().text();
         return false;
     }
-    
-    return true;
-}
 
-QVariantList Database::getAllGroups()
-{
-    QVariantList result = getGroupsRecursive(-1);
-    return result;
+    return true;
 }
 
-QVariantList Database::getGroupsRecursive(int parentId)
+// 按图片重新统计的分组统计（与 group_stats 的列顺序一致）：
+// 未分组的图片记在 group_id = 0 的行，其子树统计等于直接统计
+static const char *ExpectedGroupStatsQuery = R"(
+    WITH direct AS (
+        SELECT CASE WHEN i.group_id > 0 THEN i.group_id ELSE 0 END AS group_id,
+               COUNT(*) AS image_count,
+               SUM(COALESCE(m.byte_size, LENGTH(i.image_data))) AS byte_size
+        FROM images i
+        LEFT JOIN image_meta m ON m.image_id = i.id
+        GROUP BY 1
+    ),
+    all_groups AS (
+        SELECT id AS group_id FROM groups
+        UNION ALL
+        SELECT 0
+    )
+    SELECT g.group_id,
+           COALESCE(d.image_count, 0),
+           COALESCE(d.byte_size, 0),
+           CASE WHEN g.group_id = 0 THEN COALESCE(d.image_count, 0) ELSE
+               (SELECT COALESCE(SUM(sd.image_count), 0) FROM group_closure c
+                JOIN direct sd ON sd.group_id = c.descendant_id
+                WHERE c.ancestor_id = g.group_id) END,
+           CASE WHEN g.group_id = 0 THEN COALESCE(d.byte_size, 0) ELSE
+               (SELECT COALESCE(SUM(sd.byte_size), 0) FROM group_closure c
+                JOIN direct sd ON sd.group_id = c.descendant_id
+                WHERE c.ancestor_id = g.group_id) END
+    FROM all_groups g
+    LEFT JOIN direct d ON d.group_id = g.group_id
+)";
+
+bool Database::createGroupStatsTable()
 {
-    QVariantList groups;
+    // 每个分组一行：直接包含的图片数量和字节数，以及包括所有子孙分组在内的数量和字节数。
+    // group_id = 0 的行统计未分组的图片。由触发器在图片增删、移动和分组移动时增量维护，
+    // 标题栏和删除确认中的计数只需按主键读取一行
     QSqlQuery query;
-    
-    if (parentId > 0) {
-        query.prepare("SELECT id, name FROM groups WHERE parent_id = ? ORDER BY name");
-        query.addBindValue(parentId);
-    } else if (parentId == 0) {
-        // 根分组的parent_id=0
-        query.prepare("SELECT id, name FROM groups WHERE parent_id = 0 ORDER BY name");
-    } else {
-        // parentId == -1 时，查询所有根分组（parent_id IS NULL）
-        query.prepare("SELECT id, name FROM groups WHERE parent_id IS NULL ORDER BY name");
-    }
-    
-    if (!query.exec()) {
+    QString createStatsTable = R"(
+        CREATE TABLE IF NOT EXISTS group_stats (
+            group_id INTEGER PRIMARY KEY,
+            direct_count INTEGER NOT NULL DEFAULT 0,
+            direct_bytes INTEGER NOT NULL DEFAULT 0,
+            subtree_count INTEGER NOT NULL DEFAULT 0,
+            subtree_bytes INTEGER NOT NULL DEFAULT 0
+        )
+    )";
+
+    if (!query.exec(createStatsTable)) {
         m_lastError = query.lastError().text();
-        return groups;
+        return false;
     }
-    
-    while (query.next()) {
-        QVariantMap group;
-        int id = query.value(0).toInt();
-        group["id"] = id;
-        group["name"] = query.value(1).toString();
-        
-        // 获取子分组
-        QVariantList children = getGroupsRecursive(id);
-        if (!children.isEmpty()) {
-            group["children"] = children;
+
+    const QStringList triggers = {
+        // 新建和删除分组：增删对应的统计行（删除前 deleteGroup 已删除其中的图片）
+        R"(
+            CREATE TRIGGER IF NOT EXISTS trg_groups_stats_insert
+            AFTER INSERT ON groups
+            BEGIN
+                INSERT OR IGNORE INTO group_stats (group_id) VALUES (NEW.id);
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS trg_groups_stats_delete
+            AFTER DELETE ON groups
+            BEGIN
+                DELETE FROM group_stats WHERE group_id = OLD.id;
+            END
+        )",
+        // 移动分组：子树的统计从原父分组的所有祖先中减去，加到新父分组的所有祖先上。
+        // 原父分组和新父分组都不在被移动的子树中，它们在闭包表中的祖先行不受移动影响，
+        // 因此与闭包表触发器的执行顺序无关
+        R"(
+            CREATE TRIGGER IF NOT EXISTS trg_groups_stats_move
+            AFTER UPDATE OF parent_id ON groups
+            WHEN OLD.parent_id IS NOT NEW.parent_id
+            BEGIN
+                UPDATE group_stats
+                SET subtree_count = subtree_count - (SELECT subtree_count FROM group_stats WHERE group_id = NEW.id),
+                    subtree_bytes = subtree_bytes - (SELECT subtree_bytes FROM group_stats WHERE group_id = NEW.id)
+                WHERE group_id IN (SELECT ancestor_id FROM group_closure WHERE descendant_id = OLD.parent_id);
+
+                UPDATE group_stats
+                SET subtree_count = subtree_count + (SELECT subtree_count FROM group_stats WHERE group_id = NEW.id),
+                    subtree_bytes = subtree_bytes + (SELECT subtree_bytes FROM group_stats WHERE group_id = NEW.id)
+                WHERE group_id IN (SELECT ancestor_id FROM group_closure WHERE descendant_id = NEW.parent_id);
+            END
+        )",
+        // 新增图片：所在分组的直接统计，以及所在分组和所有祖先的子树统计
+        R"(
+            CREATE TRIGGER IF NOT EXISTS trg_images_stats_insert
+            AFTER INSERT ON images
+            BEGIN
+                UPDATE group_stats
+                SET direct_count = direct_count + 1,
+                    direct_bytes = direct_bytes + LENGTH(NEW.image_data)
+                WHERE group_id = (CASE WHEN NEW.group_id > 0 THEN NEW.group_id ELSE 0 END);
+
+                UPDATE group_stats
+                SET subtree_count = subtree_count + 1,
+                    subtree_bytes = subtree_bytes + LENGTH(NEW.image_data)
+                WHERE group_id IN (SELECT ancestor_id FROM group_closure WHERE descendant_id = NEW.group_id)
+                   OR (group_id = 0 AND COALESCE(NEW.group_id, 0) <= 0);
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS trg_images_stats_delete
+            AFTER DELETE ON images
+            BEGIN
+                UPDATE group_stats
+                SET direct_count = direct_count - 1,
+                    direct_bytes = direct_bytes - LENGTH(OLD.image_data)
+                WHERE group_id = (CASE WHEN OLD.group_id > 0 THEN OLD.group_id ELSE 0 END);
+
+                UPDATE group_stats
+                SET subtree_count = subtree_count - 1,
+                    subtree_bytes = subtree_bytes - LENGTH(OLD.image_data)
+                WHERE group_id IN (SELECT ancestor_id FROM group_closure WHERE descendant_id = OLD.group_id)
+                   OR (group_id = 0 AND COALESCE(OLD.group_id, 0) <= 0);
+            END
+        )",
+        // 图片移动到其他分组（包括删除分组时外键将 group_id 置空）：先从原位置减去，再加到新位置
+        R"(
+            CREATE TRIGGER IF NOT EXISTS trg_images_stats_move
+            AFTER UPDATE OF group_id ON images
+            WHEN OLD.group_id IS NOT NEW.group_id
+            BEGIN
+                UPDATE group_stats
+                SET direct_count = direct_count - 1,
+                    direct_bytes = direct_bytes - LENGTH(OLD.image_data)
+                WHERE group_id = (CASE WHEN OLD.group_id > 0 THEN OLD.group_id ELSE 0 END);
+
+                UPDATE group_stats
+                SET subtree_count = subtree_count - 1,
+                    subtree_bytes = subtree_bytes - LENGTH(OLD.image_data)
+                WHERE group_id IN (SELECT ancestor_id FROM group_closure WHERE descendant_id = OLD.group_id)
+                   OR (group_id = 0 AND COALESCE(OLD.group_id, 0) <= 0);
+
+                UPDATE group_stats
+                SET direct_count = direct_count + 1,
+                    direct_bytes = direct_bytes + LENGTH(NEW.image_data)
+                WHERE group_id = (CASE WHEN NEW.group_id > 0 THEN NEW.group_id ELSE 0 END);
+
+                UPDATE group_stats
+                SET subtree_count = subtree_count + 1,
+                    subtree_bytes = subtree_bytes + LENGTH(NEW.image_data)
+                WHERE group_id IN (SELECT ancestor_id FROM group_closure WHERE descendant_id = NEW.group_id)
+                   OR (group_id = 0 AND COALESCE(NEW.group_id, 0) <= 0);
+            END
+        )"
+    };
+
+    for (const QString &trigger : triggers) {
+        if (!query.exec(trigger)) {
+            m_lastError = query.lastError().text();
+            return false;
         }
-        
-        groups.append(group);
     }
-    
-    return groups;
-}
 
-QString Database::getGroupName(int groupId)
-{
-    QSqlQuery query;
-    query.prepare("SELECT name FROM groups WHERE id = ?");
-    query.addBindValue(groupId);
-    
-    if (!query.exec() || !query.next()) {
+    // 旧数据库首次升级，或统计行与分组不对应、图片总数不一致时重建
+    if (!query.exec(R"(
+        SELECT (SELECT COUNT(*) FROM groups) + 1 = (SELECT COUNT(*) FROM group_stats)
+           AND (SELECT COUNT(*) FROM images) = (SELECT COALESCE(SUM(direct_count), 0) FROM group_stats)
+    )") || !query.next()) {
         m_lastError = query.lastError().text();
-        return QString();
+        return false;
     }
-    
-    return query.value(0).toString();
-}
+    const bool consistent = query.value(0).toBool();
+    query.finish();
 
-int Database::getGroupIdByName(const QString &name, int parentId)
-{
-    QSqlQuery query;
-    
-    if (parentId == -1) {
-        // 查询根分组（parent_id为NULL）
-        query.prepare("SELECT id FROM groups WHERE name = ? AND parent_id IS NULL");
-        query.addBindValue(name);
-    } else {
-        // 查询指定父分组下的子分组
-        query.prepare("SELECT id FROM groups WHERE name = ? AND parent_id = ?");
-        query.addBindValue(name);
-        query.addBindValue(parentId);
+    if (!consistent) {
+        return rebuildGroupStats();
     }
-    
-    if (!query.exec() || !query.next()) {
-        // 分组不存在
-        return -1;
-    }
-    
-    return query.value(0).toInt();
+
+    return true;
 }
 
-bool Database::updateGroup(int groupId, const QString &name)
+bool Database::rebuildGroupStats()
 {
-    QSqlQuery query;
-    query.prepare("UPDATE groups SET name = ? WHERE id = ?");
-    query.addBindValue(name);
-    query.addBindValue(groupId);
-    
-    if (!query.exec()) {
-        m_lastError = query.lastError().text();
+    if (!m_db.transaction()) {
+        m_lastError = m_db.lastError().text();
         return false;
     }
-    
-    return true;
-}
 
-bool Database::updateGroupParent(int groupId, int newParentId)
-{
-    QSqlQuery query;
-    
-    // 如果newParentId为0，表示移动到根分组（parent_id=NULL）
-    if (newParentId == 0) {
-        query.prepare("UPDATE groups SET parent_id = NULL WHERE id = ?");
-        query.addBindValue(groupId);
-    } else {
-        query.prepare("UPDATE groups SET parent_id = ? WHERE id = ?");
-        query.addBindValue(newParentId);
-        query.addBindValue(groupId);
+    const QString rebuildQuery = QStringLiteral(
+        "INSERT INTO group_stats (group_id, direct_count, direct_bytes, subtree_count, subtree_bytes) ")
+        + QLatin1String(ExpectedGroupStatsQuery);
+
+    for (const QString &sql : {QStringLiteral("DELETE FROM group_stats"), rebuildQuery}) {
+        CachedStatement query = cachedQuery(sql, false);
+        if (!query.exec()) {
+            m_lastError = query->lastError().text();
+            m_db.rollback();
+            return false;
+        }
     }
-    
-    if (!query.exec()) {
-        m_lastError = query.lastError().text();
+
+    if (!m_db.commit()) {
+        m_lastError = m_db.lastError().text();
+        m_db.rollback();
         return false;
     }
-    
+
+    qDebug() << "Group statistics rebuilt";
     return true;
 }
 
-bool Database::removeImage(int id)
+bool Database::verifyGroupStats(bool repair)
 {
-    QSqlQuery query;
-    query.prepare("DELETE FROM images WHERE id = ?");
-    query.addBindValue(id);
-    
-    if (!query.exec()) {
-        m_lastError = query.lastError().text();
+    // 重新统计全部图片，与存储的统计逐行比较（双向差集，缺行和多余的行都算不一致）
+    const QString storedColumns = QStringLiteral(
+        "SELECT group_id, direct_count, direct_bytes, subtree_count, subtree_bytes FROM group_stats");
+    const QString expected = QLatin1String(ExpectedGroupStatsQuery);
+    const QString verifyQuery = QStringLiteral(
+        "SELECT (SELECT COUNT(*) FROM (SELECT * FROM (%1) EXCEPT %2))"
+        " + (SELECT COUNT(*) FROM (%2 EXCEPT SELECT * FROM (%1)))")
+        .arg(expected, storedColumns);
+
+    int mismatches = 0;
+    {
+        CachedStatement query = cachedQuery(verifyQuery, false);
+        if (!query.exec() || !query.next()) {
+            m_lastError = query->lastError().text();
+            return false;
+        }
+        mismatches = query.value(0).toInt();
+    }
+
+    if (mismatches == 0) {
+        return true;
+    }
+
+    qWarning() << "Group statistics mismatch:" << mismatches << "rows";
+    if (!repair) {
         return false;
     }
-    
-    return true;
+    return rebuildGroupStats();
 }
 
-bool Database::renameImage(int imageId, const QString &newFilename)
+void Database::startBackgroundMigrations()
 {
-    QSqlQuery query;
-    query.prepare("UPDATE images SET filename = ? WHERE id = ?");
-    query.addBindValue(newFilename);
-    query.addBindValue(imageId);
-    
-    if (!query.exec()) {
-        m_lastError = query.lastError().text();
-        return false;
+    int version = 0;
+    {
+        CachedStatement query = cachedQuery("PRAGMA user_version");
+        if (query.exec() && query.next()) {
+            version = query.value(0).toInt();
+        }
     }
-    
-    return true;
+    if (version >= SchemaVersionContentHashes) {
+        return;
+    }
+
+    // 各步骤依次执行，前一步未完成时不进入下一步，以免提前写入更高的结构版本
+    m_migrationFuture = QtConcurrent::run([this, version]() {
+        BulkWriteScope bulkWrite(threadConnection(), m_bulkWriters);
+        if (version < SchemaVersionNarrowThumbnails && !migrateThumbnails()) {
+            return;
+        }
+        if (version < SchemaVersionPyramid && !backfillPyramid()) {
+            return;
+        }
+        if (version < SchemaVersionImageMetadata && !backfillImageMetadata()) {
+            return;
+        }
+        backfillContentHashes();
+    });
 }
 
-bool Database::updateImageGroup(int imageId, int newGroupId)
+bool Database::migrateThumbnails()
 {
-    QSqlQuery query;
-    query.prepare("UPDATE images SET group_id = ? WHERE id = ?");
-    
-    // 如果newGroupId == -1，则设置为NULL，表示未分组
-    if (newGroupId == -1) {
-        query.addBindValue(QVariant()); // 使用默认构造的QVariant表示NULL值
-    } else {
-        query.addBindValue(newGroupId);
-    }
-    
-    query.addBindValue(imageId);
-    
-    if (!query.exec()) {
-        m_lastError = query.lastError().text();
-        return false;
+    bool completed = false;
+    {
+        QSqlDatabase db = threadConnection();
+        if (db.isOpen()) {
+            CachedStatement idQuery = cachedQuery("SELECT id FROM images WHERE id > ? ORDER BY id LIMIT 100");
+            CachedStatement thumbnailQuery = cachedQuery(R"(
+                INSERT OR IGNORE INTO image_thumbnails (image_id, thumbnail)
+                SELECT id, thumbnail FROM images
+                WHERE id BETWEEN ? AND ? AND thumbnail IS NOT NULL
+            )");
+            CachedStatement metaQuery = cachedQuery(R"(
+                INSERT OR IGNORE INTO image_meta (image_id, image_format, byte_size)
+                SELECT id, image_format, LENGTH(image_data) FROM images
+                WHERE id BETWEEN ? AND ?
+            )");
+
+            // 每批一个小事务，前台读取只会被短暂阻塞
+            int lastId = 0;
+            while (!m_shuttingDown) {
+                idQuery->bindValue(0, lastId);
+                if (!idQuery.exec()) {
+                    qWarning() << "Thumbnail migration failed:" << idQuery->lastError().text();
+                    break;
+                }
+                int firstId = -1;
+                while (idQuery.next()) {
+                    if (firstId < 0) {
+                        firstId = idQuery.value(0).toInt();
+                    }
+                    lastId = idQuery.value(0).toInt();
+                }
+                idQuery->finish();
+
+                if (firstId < 0) {
+                    // 全部迁移完成，记录结构版本
+                    cachedQuery(QString("PRAGMA user_version = %1").arg(SchemaVersionNarrowThumbnails), false).exec();
+                    qDebug() << "Thumbnail migration completed";
+                    completed = true;
+                    break;
+                }
+
+                db.transaction();
+                thumbnailQuery->bindValue(0, firstId);
+                thumbnailQuery->bindValue(1, lastId);
+                metaQuery->bindValue(0, firstId);
+                metaQuery->bindValue(1, lastId);
+                if (!thumbnailQuery.exec() || !metaQuery.exec()) {
+                    qWarning() << "Thumbnail migration failed:" << thumbnailQuery->lastError().text() << metaQuery->lastError().text();
+                    db.rollback();
+                    break;
+                }
+                db.commit();
+            }
+        }
     }
-    
-    return true;
+    return completed;
 }
 
-bool Database::deleteGroup(int groupId)
+bool Database::backfillPyramid()
 {
-    // 开始事务
-    if (!m_db.transaction()) {
-        m_lastError = m_db.lastError().text();
+    QSqlDatabase db = threadConnection();
+    if (!db.isOpen()) {
         return false;
     }
-    
-    QSqlQuery query;
-    
-    try {
-        // 1. 使用递归CTE查询获取所有子分组ID（包括当前分组）
-        QString groupQuery = QString(R"(
-            WITH RECURSIVE all_groups AS (
-                SELECT id FROM groups WHERE id = %1
-                UNION ALL
-                SELECT g.id FROM groups g
-                JOIN all_groups ag ON g.parent_id = ag.id
-            )
-            SELECT id FROM all_groups
-        )").arg(groupId);
-        
-        if (!query.exec(groupQuery)) {
-            throw query.lastError().text();
+
+    CachedStatement idQuery = cachedQuery(R"(
+        SELECT i.id, COALESCE(m.image_format, i.image_format)
+        FROM images i LEFT JOIN image_meta m ON m.image_id = i.id
+        WHERE i.id > ? AND NOT EXISTS (SELECT 1 FROM image_pyramid p WHERE p.image_id = i.id)
+        ORDER BY i.id LIMIT 20
+    )");
+    CachedStatement insertQuery = cachedQuery("INSERT OR REPLACE INTO image_pyramid (image_id, max_edge, data) VALUES (?, ?, ?)");
+
+    const int smallestLevel = PyramidLevels[0];
+    const int largestLevel = PyramidLevels[std::size(PyramidLevels) - 1];
+
+    int lastId = 0;
+    while (!m_shuttingDown) {
+        idQuery->bindValue(0, lastId);
+        if (!idQuery.exec()) {
+            qWarning() << "Pyramid backfill failed:" << idQuery->lastError().text();
+            return false;
         }
-        
-        // 收集所有分组ID
-        QStringList groupIdStrings;
-        while (query.next()) {
-            groupIdStrings.append(QString::number(query.value(0).toInt()));
+        QList<QPair<int, QString>> batch;
+        while (idQuery.next()) {
+            batch.append(qMakePair(idQuery.value(0).toInt(), idQuery.value(1).toString()));
         }
-        
-        // 2. 删除这些分组下的所有图片
-        if (!groupIdStrings.isEmpty()) {
-            QString groupIdsJoined = groupIdStrings.join(",");
-            QString imageQuery = QString(R"(
-                DELETE FROM images
-                WHERE group_id IN (%1)
-            )").arg(groupIdsJoined);
-            
-            if (!query.exec(imageQuery)) {
-                throw query.lastError().text();
+        idQuery->finish();
+
+        if (batch.isEmpty()) {
+            cachedQuery(QString("PRAGMA user_version = %1").arg(SchemaVersionPyramid), false).exec();
+            qDebug() << "Pyramid backfill completed";
+            return true;
+        }
+
+        // 解码和编码在事务之外进行，写事务只包含插入
+        QList<QPair<int, QList<QPair<int, QByteArray>>>> encoded;
+        for (const auto &item : batch) {
+            if (m_shuttingDown) {
+                break;
             }
-            
-            qDebug() << "Deleted images for groups:" << groupIdsJoined << "Deleted count:" << query.numRowsAffected();
+            lastId = item.first;
+
+            BlobReadDevice device(db, "images", "image_data", item.first);
+            device.setProfiler(activeQueryProfiler(), IMAGEDB_CALLER_NAME);
+            if (!device.open(QIODevice::ReadOnly)) {
+                continue;
+            }
+            QImageReader reader(&device, item.second.toUtf8());
+
+            // 原图不大于最小一级时无需生成，按需直接解码原图即可
+            QSize size = reader.size();
+            if (size.isValid() && qMax(size.width(), size.height()) < smallestLevel) {
+                continue;
+            }
+            // 只解码到最大一级的尺寸，JPEG 可直接在 DCT 域缩小
+            if (size.isValid()) {
+                QSize scaledSize = boundedSize(size, QSize(largestLevel, largestLevel));
+                if (scaledSize != size) {
+                    reader.setScaledSize(scaledSize);
+                }
+            }
+
+            QImage image = reader.read();
+            if (image.isNull()) {
+                continue;
+            }
+            encoded.append(qMakePair(item.first, encodePyramid(image)));
         }
-        
-        // 3. 删除所有子分组（包括当前分组）
-        if (!groupIdStrings.isEmpty()) {
-            QString groupIdsJoined = groupIdStrings.join(",");
-            QString deleteGroupQuery = QString(R"(
-                DELETE FROM groups
-                WHERE id IN (%1)
-            )").arg(groupIdsJoined);
-            
-            if (!query.exec(deleteGroupQuery)) {
-                throw query.lastError().text();
+
+        if (encoded.isEmpty()) {
+            continue;
+        }
+
+        db.transaction();
+        bool ok = true;
+        for (const auto &item : encoded) {
+            for (const auto &level : item.second) {
+                insertQuery->bindValue(0, item.first);
+                insertQuery->bindValue(1, level.first);
+                insertQuery->bindValue(2, level.second);
+                if (!insertQuery.exec()) {
+                    ok = false;
+                    break;
+                }
+            }
+            if (!ok) {
+                break;
             }
-            
-            qDebug() << "Deleted groups:" << groupIdsJoined << "Deleted count:" << query.numRowsAffected();
         }
-        
-        // 提交事务
-        if (!m_db.commit()) {
-            throw m_db.lastError().text();
+        if (!ok) {
+            qWarning() << "Pyramid backfill failed:" << insertQuery->lastError().text();
+            db.rollback();
+            return false;
         }
-        
-        return true;
-    } catch (const QString &error) {
-        // 回滚事务
-        m_db.rollback();
-        m_lastError = error;
-        qDebug() << "Delete group failed:" << error;
-        return false;
+        db.commit();
     }
+    return false;
 }
 
-int Database::getSubgroupCount(int groupId)
+bool Database::backfillImageMetadata()
 {
-    // 计算指定分组的所有子分组数量（包括嵌套子分组）
-    int count = 0;
-    QSqlQuery query;
-    
-    // 使用递归CTE查询获取所有子分组
-    QString recursiveQuery = QString(R"(
-        WITH RECURSIVE subgroups AS (
-            SELECT id FROM groups WHERE parent_id = %1
-            UNION ALL
-            SELECT g.id FROM groups g
-            JOIN subgroups s ON g.parent_id = s.id
-        )
-        SELECT COUNT(*) FROM subgroups
-    )").arg(groupId);
-    
-    if (!query.exec(recursiveQuery)) {
-        m_lastError = query.lastError().text();
-        return 0;
-    }
-    
-    if (query.next()) {
-        count = query.value(0).toInt();
+    QSqlDatabase db = threadConnection();
+    if (!db.isOpen()) {
+        return false;
     }
-    
-    return count;
-}
 
-int Database::getImageCountForGroup(int groupId)
-{
-    // 计算指定分组及其所有子分组下的图片数量
-    int count = 0;
-    QSqlQuery query;
+    CachedStatement idQuery = cachedQuery(R"(
+        SELECT image_id, image_format FROM image_meta
+        WHERE image_id > ? AND width IS NULL
+        ORDER BY image_id LIMIT 100
+    )");
+    CachedStatement updateQuery = cachedQuery(R"(
+        UPDATE image_meta SET width = ?, height = ?, pixel_format = ?, color_depth = ?
+        WHERE image_id = ?
+    )");
+
+    int lastId = 0;
+    while (!m_shuttingDown) {
+        idQuery->bindValue(0, lastId);
+        if (!idQuery.exec()) {
+            qWarning() << "Image metadata backfill failed:" << idQuery->lastError().text();
+            return false;
+        }
+        QList<QPair<int, QString>> batch;
+        while (idQuery.next()) {
+            batch.append(qMakePair(idQuery.value(0).toInt(), idQuery.value(1).toString()));
+        }
+        idQuery->finish();
 
-    // 使用递归CTE查询获取所有子孙分组ID，包括当前分组
-    QString recursiveQuery = QString(R"(
-        WITH RECURSIVE all_groups AS (
-            SELECT id FROM groups WHERE id = %1
-            UNION ALL
-            SELECT g.id FROM groups g
-            JOIN all_groups ag ON g.parent_id = ag.id
-        )
-        SELECT COUNT(*) FROM images
-        WHERE group_id IN (SELECT id FROM all_groups)
-    )").arg(groupId);
+        if (batch.isEmpty()) {
+            cachedQuery(QString("PRAGMA user_version = %1").arg(SchemaVersionImageMetadata), false).exec();
+            qDebug() << "Image metadata backfill completed";
+            return true;
+        }
 
-    if (!query.exec(recursiveQuery)) {
-        m_lastError = query.lastError().text();
-        return 0;
-    }
+        // 只读取每张原图开头的文件头，不解码像素；读取失败的记为 0，不再重复尝试
+        QList<QPair<int, ImageMetadata>> results;
+        for (const auto &item : batch) {
+            if (m_shuttingDown) {
+                break;
+            }
+            lastId = item.first;
 
-    if (query.next()) {
-        count = query.value(0).toInt();
+            ImageMetadata metadata;
+            BlobReadDevice device(db, "images", "image_data", item.first);
+            device.setProfiler(activeQueryProfiler(), IMAGEDB_CALLER_NAME);
+            if (device.open(QIODevice::ReadOnly)) {
+                metadata = readImageMetadata(&device, item.second.toUtf8());
+            }
+            results.append(qMakePair(item.first, metadata));
+        }
+
+        db.transaction();
+        for (const auto &result : results) {
+            updateQuery->bindValue(0, result.second.width);
+            updateQuery->bindValue(1, result.second.height);
+            updateQuery->bindValue(2, result.second.pixelFormat);
+            updateQuery->bindValue(3, result.second.colorDepth);
+            updateQuery->bindValue(4, result.first);
+            if (!updateQuery.exec()) {
+                qWarning() << "Image metadata backfill failed:" << updateQuery->lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+        db.commit();
     }
+    return false;
+}
 
-    return count;
+ImageMetadata Database::readImageMetadata(QIODevice *device, const QByteArray &format)
+{
+    // size() 和 imageFormat() 只解析文件头，不解码像素数据
+    ImageMetadata metadata;
+    QImageReader reader(device, format);
+    const QSize size = reader.size();
+    if (size.isValid()) {
+        metadata.width = size.width();
+        metadata.height = size.height();
+    }
+    const QImage::Format pixelFormat = reader.imageFormat();
+    if (pixelFormat != QImage::Format_Invalid) {
+        metadata.pixelFormat = pixelFormat;
+        metadata.colorDepth = QImage::toPixelFormat(pixelFormat).bitsPerPixel();
+    }
+    return metadata;
 }
 
-int Database::getImageCountDirect(int groupId)
+// 文件头中缺少的信息由已解码的图片补齐（导入时本来就要解码生成缩略图）
+static void completeMetadata(ImageMetadata &metadata, const QImage &image)
 {
-    // 计算指定分组直接包含的图片数量（不包括子孙分组）
-    int count = 0;
-    QSqlQuery query;
+    if (!metadata.isValid()) {
+        metadata.width = image.width();
+        metadata.height = image.height();
+    }
+    if (metadata.pixelFormat == QImage::Format_Invalid) {
+        metadata.pixelFormat = image.format();
+        metadata.colorDepth = image.depth();
+    }
+}
 
-    query.prepare("SELECT COUNT(*) FROM images WHERE group_id = ?");
-    query.addBindValue(groupId);
+// 用户设置相关方法实现
 
-    if (!query.exec()) {
-        m_lastError = query.lastError().text();
+// 保存单个设置
+bool Database::saveSetting(const QString &key, const QString &value)
+{
+    // 使用UPSERT语法（SQLite 3.24.0+支持）
+    CachedStatement query = cachedQuery(R"(
+        INSERT INTO user_settings (setting_key, setting_value, updated_time)
+        VALUES (:key, :value, CURRENT_TIMESTAMP)
+        ON CONFLICT(setting_key) DO UPDATE SET
+            setting_value = :value,
+            updated_time = CURRENT_TIMESTAMP
+    )");
+    query->bindValue(":key", key);
+    query->bindValue(":value", value);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+// 获取单个设置
+QString Database::getSetting(const QString &key, const QString &defaultValue)
+{
+    CachedStatement query = cachedQuery("SELECT setting_value FROM user_settings WHERE setting_key = :key");
+    query->bindValue(":key", key);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return defaultValue;
+    }
+    
+    if (query.next()) {
+        return query.value(0).toString();
+    }
+    
+    return defaultValue;
+}
+
+// 获取所有设置
+QVariantMap Database::getAllSettings()
+{
+    QVariantMap settings;
+    CachedStatement query = cachedQuery("SELECT setting_key, setting_value FROM user_settings");
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return settings;
+    }
+    
+    while (query.next()) {
+        QString key = query.value(0).toString();
+        QString value = query.value(1).toString();
+        settings.insert(key, value);
+    }
+    
+    return settings;
+}
+
+bool Database::insertImage(const QString &fileName, int groupId)
+{
+    // 正常导入单个图片
+    QImage image(fileName);
+    if (image.isNull()) {
+        m_lastError = "Failed to load image: " + fileName;
+        return false;
+    }
+    
+    return insertImage(fileName, image, groupId);
+}
+
+bool Database::insertImage(const QUrl &fileUrl, int groupId)
+{
+    // 处理URL类型的文件路径
+    QString fileName = fileUrl.toLocalFile();
+    if (fileName.isEmpty()) {
+        m_lastError = "Invalid file URL: " + fileUrl.toString();
+        return false;
+    }
+    
+    return insertImage(fileName, groupId);
+}
+
+bool Database::insertImage(const QString &fileName, const QImage &image, int groupId)
+{
+    ImageRecord record;
+    record.filePath = fileName;
+    record.fileName = QFileInfo(fileName).fileName();
+
+    // 1. 获取原始图片格式
+    record.imageFormat = imageFormatForFile(fileName);
+
+    // 2. 直接从文件读取原始图片数据，避免重新编码导致的质量损失和性能问题
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_lastError = "Failed to open file: " + fileName;
+        return false;
+    }
+    record.imageData = file.readAll();
+    file.close();
+    record.contentHash = computeContentHash(record.imageData);
+
+    // 3. 记录尺寸和像素格式，生成缩略图和多分辨率缩略图
+    QBuffer headerBuffer(&record.imageData);
+    headerBuffer.open(QIODevice::ReadOnly);
+    record.metadata = readImageMetadata(&headerBuffer);
+    headerBuffer.close();
+    completeMetadata(record.metadata, image);
+    record.thumbnailData = encodeThumbnail(image);
+    record.pyramidData = encodePyramid(image);
+    record.groupId = groupId;
+
+    // 4. 写入数据库
+    ImageBatchWriter writer(m_db);
+    writer.setProfiler(activeQueryProfiler());
+    writer.setCommitCallback([this](const QList<int> &imageIds) {
+        emit imagesChanged(imageIds);
+    });
+    if (!writer.add(record) || !writer.commit()) {
+        m_lastError = writer.lastError();
+        return false;
+    }
+
+    return true;
+}
+
+QString Database::imageFormatForFile(const QString &fileName)
+{
+    QString fileExtension = QFileInfo(fileName).suffix().toUpper();
+    QString imageFormat = "JPG"; // 默认格式
+
+    // 根据文件扩展名设置图片格式
+    if (fileExtension == "PNG") {
+        imageFormat = "PNG";
+    } else if (fileExtension == "BMP") {
+        imageFormat = "BMP";
+    } else if (fileExtension == "GIF") {
+        imageFormat = "GIF";
+    } else if (fileExtension == "JPG" || fileExtension == "JPEG") {
+        imageFormat = "JPG";
+    } else if (fileExtension == "WEBP") {
+        imageFormat = "WEBP";
+    }
+
+    return imageFormat;
+}
+
+QByteArray Database::encodeThumbnail(const QImage &image)
+{
+    // 生成缩略图（宽度固定为140px，高度自适应，保持比例）
+    QImage thumbnail = image.scaled(
+        ThumbnailWidth, // 固定宽度
+        ThumbnailHeight, // 最大高度210px
+        Qt::KeepAspectRatio, // 保持比例
+        Qt::FastTransformation // 快速缩放，缩略图不需要平滑算法，提高生成速度
+    );
+
+    QByteArray thumbnailData;
+    QBuffer thumbnailBuffer(&thumbnailData);
+    thumbnailBuffer.open(QIODevice::WriteOnly);
+    thumbnail.save(&thumbnailBuffer, "JPG", 85); // 缩略图统一使用JPG格式，质量85
+    return thumbnailData;
+}
+
+QList<QPair<int, QByteArray>> Database::encodePyramid(const QImage &image)
+{
+    // 从最大一级开始逐级缩小，较小的级别由上一级生成，避免每级都从原图缩放
+    QList<QPair<int, QByteArray>> levels;
+    const int longEdge = qMax(image.width(), image.height());
+    QImage level = image;
+
+    for (int i = int(std::size(PyramidLevels)) - 1; i >= 0; --i) {
+        const int maxEdge = PyramidLevels[i];
+        // 原图比该级还小时不生成，请求这一尺寸时直接解码原图，开销与读取缩略图相当
+        if (longEdge < maxEdge) {
+            continue;
+        }
+        level = level.scaled(maxEdge, maxEdge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        level.save(&buffer, "JPG", 85); // 与基础缩略图一致，统一使用JPG格式，质量85
+        levels.prepend(qMakePair(maxEdge, data));
+    }
+
+    return levels;
+}
+
+QByteArray Database::computeContentHash(const QByteArray &data)
+{
+    // BLAKE2b-160：速度快且碰撞概率可以忽略，20字节便于建立紧凑索引
+    return QCryptographicHash::hash(data, QCryptographicHash::Blake2b_160);
+}
+
+ImageRecord Database::prepareImageRecord(const QUrl &fileUrl, const std::function<bool(const QByteArray &)> &isDuplicate)
+{
+    ImageRecord record;
+    record.filePath = fileUrl.toLocalFile();
+    record.fileName = QFileInfo(record.filePath).fileName();
+    record.folderName = importFolderName(fileUrl);
+
+    if (record.filePath.isEmpty()) {
+        record.error = "Invalid file URL: " + fileUrl.toString();
+        return record;
+    }
+
+    record.imageFormat = imageFormatForFile(record.filePath);
+
+    // 只读取一次文件，原始字节既用于存储也用于解码
+    QFile file(record.filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        record.error = "Failed to open file: " + record.filePath;
+        return record;
+    }
+    record.imageData = file.readAll();
+    file.close();
+    record.contentHash = computeContentHash(record.imageData);
+
+    // 重复图片直接跳过，不做任何解码和缩略图工作
+    if (isDuplicate && isDuplicate(record.contentHash)) {
+        record.duplicate = true;
+        record.imageData.clear();
+        return record;
+    }
+
+    // 尺寸和像素格式取自文件头
+    QBuffer headerBuffer(&record.imageData);
+    headerBuffer.open(QIODevice::ReadOnly);
+    record.metadata = readImageMetadata(&headerBuffer);
+    headerBuffer.close();
+
+    QImage image;
+    if (!image.loadFromData(record.imageData)) {
+        record.error = "Failed to load image: " + record.filePath;
+        record.imageData.clear();
+        return record;
+    }
+
+    completeMetadata(record.metadata, image);
+    record.thumbnailData = encodeThumbnail(image);
+    record.pyramidData = encodePyramid(image);
+    return record;
+}
+
+int Database::insertImages(const QList<ImageRecord> &records, int maxRows, qint64 maxBytes)
+{
+    // 可能在工作线程中调用（如基准测试），按线程取连接；主线程即为主连接
+    QSqlDatabase db = threadConnection();
+    BulkWriteScope bulkWrite(db, m_bulkWriters);
+    ImageBatchWriter writer(db, maxRows, maxBytes);
+    writer.setProfiler(activeQueryProfiler());
+    writer.setCommitCallback([this](const QList<int> &imageIds) {
+        emit imagesChanged(imageIds);
+    });
+    for (const ImageRecord &record : records) {
+        if (!record.isValid() || record.duplicate) {
+            if (!record.isValid()) {
+                m_lastError = record.error;
+            }
+            continue;
+        }
+        if (!writer.add(record)) {
+            m_lastError = writer.lastError();
+        }
+    }
+
+    if (!writer.commit()) {
+        m_lastError = writer.lastError();
+    }
+
+    return writer.insertedCount();
+}
+
+int Database::insertImageFiles(const QList<QUrl> &fileUrls, int groupId)
+{
+    // 分块处理，避免一次性把所有原始文件读入内存
+    const int chunkSize = ImageBatchWriter::DefaultMaxRows;
+    int insertedCount = 0;
+
+    for (int offset = 0; offset < fileUrls.size(); offset += chunkSize) {
+        QList<ImageRecord> records = QtConcurrent::blockingMapped(m_importPool, fileUrls.mid(offset, chunkSize),
+                                                                  [](const QUrl &fileUrl) {
+            return prepareImageRecord(fileUrl);
+        });
+        for (ImageRecord &record : records) {
+            record.groupId = groupId;
+        }
+        insertedCount += insertImages(records);
+    }
+
+    return insertedCount;
+}
+
+ImageBatchWriter::ImageBatchWriter(const QSqlDatabase &db, int maxRows, qint64 maxBytes)
+    : m_db(db), m_query(db), m_thumbnailQuery(db), m_metaQuery(db), m_hashQuery(db), m_pyramidQuery(db),
+      m_savepointQuery(db), m_releaseQuery(db), m_rollbackToQuery(db),
+      m_maxRows(qMax(1, maxRows)), m_maxBytes(qMax<qint64>(1, maxBytes))
+{
+    // 整个批次只编译一次语句；缩略图和元数据写入窄表，images.thumbnail 仅保留给旧数据
+    m_query.prepare("INSERT INTO images (filename, image_data, image_format, group_id) VALUES (?, ?, ?, ?)");
+    m_thumbnailQuery.prepare("INSERT OR REPLACE INTO image_thumbnails (image_id, thumbnail) VALUES (?, ?)");
+    m_metaQuery.prepare(R"(
+        INSERT OR REPLACE INTO image_meta (image_id, image_format, byte_size, width, height, pixel_format, color_depth)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+    )");
+    m_hashQuery.prepare("INSERT OR REPLACE INTO image_hashes (image_id, content_hash) VALUES (?, ?)");
+    m_pyramidQuery.prepare("INSERT OR REPLACE INTO image_pyramid (image_id, max_edge, data) VALUES (?, ?, ?)");
+    // 每条记录一个保存点：任一步失败时撤销这条记录已写入的行，不影响同批的其他记录
+    m_savepointQuery.prepare("SAVEPOINT image_record");
+    m_releaseQuery.prepare("RELEASE image_record");
+    m_rollbackToQuery.prepare("ROLLBACK TO image_record");
+}
+
+ImageBatchWriter::~ImageBatchWriter()
+{
+    commit();
+}
+
+bool ImageBatchWriter::add(const ImageRecord &record)
+{
+    if (!m_inTransaction) {
+        if (!m_db.transaction()) {
+            m_lastError = m_db.lastError().text();
+            return false;
+        }
+        m_inTransaction = true;
+    }
+
+    if (!statement(m_savepointQuery).exec()) {
+        m_lastError = m_savepointQuery.lastError().text();
+        return false;
+    }
+
+    int imageId = -1;
+    if (!writeRecord(record, &imageId)) {
+        // ROLLBACK TO 之后保存点仍在栈上，需再 RELEASE；外层批次事务保持打开
+        statement(m_rollbackToQuery).exec();
+        statement(m_releaseQuery).exec();
+        return false;
+    }
+    if (!statement(m_releaseQuery).exec()) {
+        m_lastError = m_releaseQuery.lastError().text();
+        statement(m_rollbackToQuery).exec();
+        statement(m_releaseQuery).exec();
+        return false;
+    }
+
+    m_pendingIds.append(imageId);
+    m_pendingRows++;
+    m_pendingBytes += recordBytes(record);
+
+    // 达到行数或字节数阈值时提交
+    if (m_pendingRows >= m_maxRows || m_pendingBytes >= m_maxBytes) {
+        return commit();
+    }
+
+    return true;
+}
+
+qint64 ImageBatchWriter::recordBytes(const ImageRecord &record)
+{
+    qint64 bytes = record.imageData.size() + record.thumbnailData.size();
+    for (const auto &level : record.pyramidData) {
+        bytes += level.second.size();
+    }
+    return bytes;
+}
+
+bool ImageBatchWriter::writeRecord(const ImageRecord &record, int *imageId)
+{
+    m_query.bindValue(0, record.fileName);
+    m_query.bindValue(1, record.imageData);
+    m_query.bindValue(2, record.imageFormat);
+    // groupId <= 0 时写入NULL，表示未分组
+    m_query.bindValue(3, record.groupId > 0 ? QVariant(record.groupId) : QVariant());
+
+    QVariant insertedId;
+    {
+        // 语句 finish() 之后读不到 lastInsertId，需在作用域内读取
+        CachedStatement insert = statement(m_query);
+        if (!insert.exec()) {
+            m_lastError = m_query.lastError().text();
+            return false;
+        }
+        insertedId = insert->lastInsertId();
+    }
+
+    m_metaQuery.bindValue(0, insertedId);
+    m_metaQuery.bindValue(1, record.imageFormat);
+    m_metaQuery.bindValue(2, record.imageData.size());
+    m_metaQuery.bindValue(3, record.metadata.width);
+    m_metaQuery.bindValue(4, record.metadata.height);
+    m_metaQuery.bindValue(5, record.metadata.pixelFormat);
+    m_metaQuery.bindValue(6, record.metadata.colorDepth);
+    if (!statement(m_metaQuery).exec()) {
+        m_lastError = m_metaQuery.lastError().text();
+        return false;
+    }
+
+    if (!record.thumbnailData.isEmpty()) {
+        m_thumbnailQuery.bindValue(0, insertedId);
+        m_thumbnailQuery.bindValue(1, record.thumbnailData);
+        if (!statement(m_thumbnailQuery).exec()) {
+            m_lastError = m_thumbnailQuery.lastError().text();
+            return false;
+        }
+    }
+
+    if (!record.contentHash.isEmpty()) {
+        m_hashQuery.bindValue(0, insertedId);
+        m_hashQuery.bindValue(1, record.contentHash);
+        if (!statement(m_hashQuery).exec()) {
+            m_lastError = m_hashQuery.lastError().text();
+            return false;
+        }
+    }
+
+    for (const auto &level : record.pyramidData) {
+        m_pyramidQuery.bindValue(0, insertedId);
+        m_pyramidQuery.bindValue(1, level.first);
+        m_pyramidQuery.bindValue(2, level.second);
+        if (!statement(m_pyramidQuery).exec()) {
+            m_lastError = m_pyramidQuery.lastError().text();
+            return false;
+        }
+    }
+
+    *imageId = insertedId.toInt();
+    return true;
+}
+
+CachedStatement ImageBatchWriter::statement(QSqlQuery &query, const char *caller)
+{
+    CachedStatement borrowed(&query, nullptr);
+    if (m_profiler) {
+        borrowed.setProfiler(m_profiler, caller);
+    }
+    return borrowed;
+}
+
+bool ImageBatchWriter::commit()
+{
+    if (!m_inTransaction) {
+        return true;
+    }
+
+    m_inTransaction = false;
+    m_pendingRows = 0;
+    m_pendingBytes = 0;
+    const QList<int> committedIds = std::exchange(m_pendingIds, {});
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool committed = m_db.commit();
+    if (m_profiler) {
+        m_profiler->record("COMMIT", IMAGEDB_CALLER_NAME, timer.nsecsElapsed(), 0, 0);
+    }
+    if (!committed) {
+        m_lastError = m_db.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+
+    m_insertedCount += committedIds.size();
+    if (m_commitCallback && !committedIds.isEmpty()) {
+        m_commitCallback(committedIds);
+    }
+
+    return true;
+}
+
+QString Database::getImageFilename(int id)
+{
+    CachedStatement query = cachedQuery("SELECT filename FROM images WHERE id = ?");
+    query->bindValue(0, id);
+    
+    if (!query.exec() || !query.next()) {
+        m_lastError = query->lastError().text();
+        return QString();
+    }
+    
+    return query.value(0).toString();
+}
+
+QList<int> Database::getAllImageIds(int groupId)
+{
+    QList<int> ids;
+    const char *sql = nullptr;
+    
+    if (groupId > 0) {
+        // 返回指定分组的图片
+        sql = "SELECT id FROM images WHERE group_id = ? ORDER BY id";
+    } else if (groupId == -1) {
+        // 返回未分组的图片（group_id为NULL或-1）
+        sql = "SELECT id FROM images WHERE group_id IS NULL OR group_id = -1 ORDER BY id";
+    } else {
+        // 返回所有图片（如果需要的话）
+        sql = "SELECT id FROM images ORDER BY id";
+    }
+    
+    CachedStatement query = cachedQuery(sql);
+    if (groupId > 0) {
+        query->bindValue(0, groupId);
+    }
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return ids;
+    }
+    
+    while (query.next()) {
+        ids.append(query.value(0).toInt());
+    }
+    
+    return ids;
+}
+
+// 图片列表行的公共查询：字节数优先从元数据窄表读取，不读取原图数据
+static const char *ImageListEntryColumns = R"(
+    SELECT i.id, i.group_id, i.filename, COALESCE(m.byte_size, LENGTH(i.image_data)),
+           COALESCE(m.width, 0), COALESCE(m.height, 0)
+    FROM images i LEFT JOIN image_meta m ON m.image_id = i.id
+)";
+
+static ImageListEntry imageListEntryFromQuery(const QSqlQuery &query)
+{
+    ImageListEntry entry;
+    entry.id = query.value(0).toInt();
+    entry.groupId = query.value(1).isNull() ? -1 : query.value(1).toInt();
+    entry.filename = query.value(2).toString();
+    entry.byteSize = query.value(3).toLongLong();
+    entry.width = query.value(4).toInt();
+    entry.height = query.value(5).toInt();
+    return entry;
+}
+
+QList<ImageListEntry> Database::getImageListEntries(int groupId, int afterId, int limit)
+{
+    QList<ImageListEntry> entries;
+
+    // 按 id 翻页（而不是 OFFSET），每页的开销与已读取的行数无关
+    QString sql = ImageListEntryColumns;
+    if (groupId > 0) {
+        sql += " WHERE i.group_id = ? AND i.id > ? ORDER BY i.id LIMIT ?";
+    } else if (groupId == -1) {
+        sql += " WHERE (i.group_id IS NULL OR i.group_id = -1) AND i.id > ? ORDER BY i.id LIMIT ?";
+    } else {
+        sql += " WHERE i.id > ? ORDER BY i.id LIMIT ?";
+    }
+
+    CachedStatement query = cachedQuery(sql);
+    int index = 0;
+    if (groupId > 0) {
+        query->bindValue(index++, groupId);
+    }
+    query->bindValue(index++, afterId);
+    query->bindValue(index++, limit);
+
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return entries;
+    }
+
+    while (query.next()) {
+        entries.append(imageListEntryFromQuery(*query));
+    }
+
+    return entries;
+}
+
+QList<ImageListEntry> Database::getImageListEntries(const QList<int> &imageIds)
+{
+    QList<ImageListEntry> entries;
+    if (imageIds.isEmpty()) {
+        return entries;
+    }
+
+    // 与 getImageInfos 相同，按 500 个ID一块用 IN 查询，一次导入提交的整批只需一两条语句
+    const int chunkSize = 500;
+    for (int offset = 0; offset < imageIds.size(); offset += chunkSize) {
+        const QList<int> chunk = imageIds.mid(offset, chunkSize);
+        QStringList placeholders;
+        for (int i = 0; i < chunk.size(); i++) {
+            placeholders.append("?");
+        }
+
+        CachedStatement query = cachedQuery(QString(ImageListEntryColumns)
+                                                + QString(" WHERE i.id IN (%1) ORDER BY i.id").arg(placeholders.join(", ")),
+                                            chunk.size() == chunkSize); // 只缓存整块的语句
+        for (int i = 0; i < chunk.size(); i++) {
+            query->bindValue(i, chunk.at(i));
+        }
+
+        if (!query.exec()) {
+            m_lastError = query->lastError().text();
+            return entries;
+        }
+
+        while (query.next()) {
+            entries.append(imageListEntryFromQuery(*query));
+        }
+    }
+
+    return entries;
+}
+
+// 分组相关方法实现
+bool Database::createGroup(const QString &name, int parentId)
+{
+    CachedStatement query = cachedQuery(parentId > 0
+                                        ? "INSERT INTO groups (name, parent_id) VALUES (?, ?)"
+                                        : "INSERT INTO groups (name) VALUES (?)");
+    query->bindValue(0, name);
+    if (parentId > 0) {
+        query->bindValue(1, parentId);
+    }
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return false;
+    }
+    
+    emit groupAdded(query->lastInsertId().toInt(), parentId > 0 ? parentId : -1, name);
+    return true;
+}
+
+QVariantList Database::getAllGroups()
+{
+    // 一次查询读取全部分组，在内存中组装嵌套结构（不再每个节点查询一次）
+    const QList<GroupEntry> entries = getGroupEntries();
+
+    QHash<int, QList<int>> childrenOf; // 父分组ID -> 子分组在 entries 中的下标（已按名称排序）
+    for (int i = 0; i < entries.size(); ++i) {
+        childrenOf[entries.at(i).parentId].append(i);
+    }
+
+    std::function<QVariantList(int)> build = [&](int parentId) {
+        QVariantList groups;
+        for (int i : childrenOf.value(parentId)) {
+            const GroupEntry &entry = entries.at(i);
+            QVariantMap group;
+            group["id"] = entry.id;
+            group["name"] = entry.name;
+
+            QVariantList children = build(entry.id);
+            if (!children.isEmpty()) {
+                group["children"] = children;
+            }
+            groups.append(group);
+        }
+        return groups;
+    };
+
+    // 根分组为 parent_id IS NULL 的分组
+    return build(-1);
+}
+
+QList<GroupEntry> Database::getGroupEntries()
+{
+    QList<GroupEntry> entries;
+    CachedStatement query = cachedQuery("SELECT id, parent_id, name FROM groups ORDER BY name");
+
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return entries;
+    }
+
+    while (query.next()) {
+        GroupEntry entry;
+        entry.id = query.value(0).toInt();
+        entry.parentId = query.value(1).isNull() ? -1 : query.value(1).toInt();
+        entry.name = query.value(2).toString();
+        entries.append(entry);
+    }
+
+    return entries;
+}
+
+QString Database::getGroupName(int groupId)
+{
+    CachedStatement query = cachedQuery("SELECT name FROM groups WHERE id = ?");
+    query->bindValue(0, groupId);
+    
+    if (!query.exec() || !query.next()) {
+        m_lastError = query->lastError().text();
+        return QString();
+    }
+    
+    return query.value(0).toString();
+}
+
+int Database::getGroupIdByName(const QString &name, int parentId)
+{
+    if (parentId == -1) {
+        // 查询根分组（parent_id为NULL）
+        CachedStatement query = cachedQuery("SELECT id FROM groups WHERE name = ? AND parent_id IS NULL");
+        query->bindValue(0, name);
+        if (!query.exec() || !query.next()) {
+            // 分组不存在
+            return -1;
+        }
+        return query.value(0).toInt();
+    }
+
+    // 查询指定父分组下的子分组
+    CachedStatement query = cachedQuery("SELECT id FROM groups WHERE name = ? AND parent_id = ?");
+    query->bindValue(0, name);
+    query->bindValue(1, parentId);
+    if (!query.exec() || !query.next()) {
+        // 分组不存在
+        return -1;
+    }
+    
+    return query.value(0).toInt();
+}
+
+bool Database::updateGroup(int groupId, const QString &name)
+{
+    CachedStatement query = cachedQuery("UPDATE groups SET name = ? WHERE id = ?");
+    query->bindValue(0, name);
+    query->bindValue(1, groupId);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return false;
+    }
+    
+    emit groupRenamed(groupId, name);
+    return true;
+}
+
+bool Database::updateGroupParent(int groupId, int newParentId)
+{
+    // 如果newParentId为0，表示移动到根分组（parent_id=NULL）
+    CachedStatement query = cachedQuery("UPDATE groups SET parent_id = ? WHERE id = ?");
+    query->bindValue(0, newParentId == 0 ? QVariant() : QVariant(newParentId));
+    query->bindValue(1, groupId);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return false;
+    }
+    
+    emit groupMoved(groupId, newParentId > 0 ? newParentId : -1);
+    return true;
+}
+
+bool Database::removeImage(int id)
+{
+    CachedStatement query = cachedQuery("DELETE FROM images WHERE id = ?");
+    query->bindValue(0, id);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return false;
+    }
+    
+    m_storageMaintenanceRequested = true;
+    emit imageInvalidated(id);
+    emit imagesChanged({ id });
+    return true;
+}
+
+bool Database::renameImage(int imageId, const QString &newFilename)
+{
+    CachedStatement query = cachedQuery("UPDATE images SET filename = ? WHERE id = ?");
+    query->bindValue(0, newFilename);
+    query->bindValue(1, imageId);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return false;
+    }
+    
+    emit imageInvalidated(imageId);
+    emit imagesChanged({ imageId });
+    return true;
+}
+
+bool Database::updateImageGroup(int imageId, int newGroupId)
+{
+    CachedStatement query = cachedQuery("UPDATE images SET group_id = ? WHERE id = ?");
+    
+    // 如果newGroupId == -1，则设置为NULL，表示未分组
+    if (newGroupId == -1) {
+        query->bindValue(0, QVariant()); // 使用默认构造的QVariant表示NULL值
+    } else {
+        query->bindValue(0, newGroupId);
+    }
+    
+    query->bindValue(1, imageId);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return false;
+    }
+    
+    emit imagesChanged({ imageId });
+    return true;
+}
+
+bool Database::deleteGroup(int groupId)
+{
+    // 开始事务
+    if (!m_db.transaction()) {
+        m_lastError = m_db.lastError().text();
+        return false;
+    }
+    
+    try {
+        // 先记下将被删除的图片，提交后通知图片缓存和列表模型
+        QList<int> deletedImageIds;
+        {
+            CachedStatement query = cachedQuery(R"(
+                SELECT i.id FROM images i
+                JOIN group_closure c ON i.group_id = c.descendant_id
+                WHERE c.ancestor_id = ?
+            )");
+            query->bindValue(0, groupId);
+
+            if (!query.exec()) {
+                throw query->lastError().text();
+            }
+
+            while (query.next()) {
+                deletedImageIds.append(query.value(0).toInt());
+            }
+        }
+
+        // 1. 删除该分组及其所有子孙分组下的图片（子孙分组由闭包表直接查出）
+        {
+            CachedStatement query = cachedQuery(R"(
+                DELETE FROM images
+                WHERE group_id IN (SELECT descendant_id FROM group_closure WHERE ancestor_id = ?)
+            )");
+            query->bindValue(0, groupId);
+
+            if (!query.exec()) {
+                throw query->lastError().text();
+            }
+
+            qDebug() << "Deleted images for group:" << groupId << "Deleted count:" << query->numRowsAffected();
+        }
+        
+        // 2. 删除所有子分组（包括当前分组），对应的闭包表行由外键级联删除
+        {
+            CachedStatement query = cachedQuery(R"(
+                DELETE FROM groups
+                WHERE id IN (SELECT descendant_id FROM group_closure WHERE ancestor_id = ?)
+            )");
+            query->bindValue(0, groupId);
+
+            if (!query.exec()) {
+                throw query->lastError().text();
+            }
+
+            qDebug() << "Deleted group:" << groupId << "Deleted count:" << query->numRowsAffected();
+        }
+        
+        // 提交事务
+        if (!m_db.commit()) {
+            throw m_db.lastError().text();
+        }
+        
+        // 删除的图片留下的空闲页由后台整理释放
+        m_storageMaintenanceRequested = true;
+        for (int imageId : std::as_const(deletedImageIds)) {
+            emit imageInvalidated(imageId);
+        }
+        if (!deletedImageIds.isEmpty()) {
+            emit imagesChanged(deletedImageIds);
+        }
+        emit groupRemoved(groupId);
+        return true;
+    } catch (const QString &error) {
+        // 回滚事务
+        m_db.rollback();
+        m_lastError = error;
+        qDebug() << "Delete group failed:" << error;
+        return false;
+    }
+}
+
+int Database::getSubgroupCount(int groupId)
+{
+    // 计算指定分组的所有子分组数量（包括嵌套子分组）
+    int count = 0;
+
+    // 闭包表中以该分组为祖先、depth > 0 的行即为全部子孙分组
+    CachedStatement query = cachedQuery("SELECT COUNT(*) FROM group_closure WHERE ancestor_id = ? AND depth > 0");
+    query->bindValue(0, groupId);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return 0;
+    }
+    
+    if (query.next()) {
+        count = query.value(0).toInt();
+    }
+    
+    return count;
+}
+
+int Database::getImageCountForGroup(int groupId)
+{
+    // 指定分组及其所有子分组下的图片数量；groupId <= 0 时为未分组的图片数量
+    return readGroupStat(groupId, "SELECT subtree_count FROM group_stats WHERE group_id = ?").toInt();
+}
+
+int Database::getImageCountDirect(int groupId)
+{
+    // 指定分组直接包含的图片数量（不包括子孙分组）
+    return readGroupStat(groupId, "SELECT direct_count FROM group_stats WHERE group_id = ?").toInt();
+}
+
+qint64 Database::getGroupByteSize(int groupId)
+{
+    // 指定分组及其所有子分组下图片的总字节数
+    return readGroupStat(groupId, "SELECT subtree_bytes FROM group_stats WHERE group_id = ?").toLongLong();
+}
+
+QVariant Database::readGroupStat(int groupId, const char *sql)
+{
+    CachedStatement query = cachedQuery(sql);
+    query->bindValue(0, groupId > 0 ? groupId : 0);
+
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return 0;
+    }
+
+    if (query.next()) {
+        return query.value(0);
+    }
+
+    return 0;
+}
+
+QImage Database::getImageAsQImage(int id, bool useThumbnail, const QSize &targetSize, QSize *originalSize, ImageLoadTiming *timing)
+{
+    // 由图片提供器的加载线程调用，使用调用线程自己的连接和语句缓存
+    QSqlDatabase db = threadConnection();
+    QByteArray imageData;
+    QString imageFormat;
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    
+    if (useThumbnail && (targetSize.width() > ThumbnailWidth || targetSize.height() > ThumbnailHeight)) {
+        // 请求尺寸超出基础缩略图：选择能覆盖请求长边的最小一级，没有合适的级别时按目标尺寸解码原图
+        CachedStatement query = cachedQuery("SELECT data FROM image_pyramid WHERE image_id = ? AND max_edge >= ? ORDER BY max_edge LIMIT 1");
+        query->bindValue(0, id);
+        query->bindValue(1, qMax(targetSize.width(), targetSize.height()));
+        if (query.exec() && query.next()) {
+            imageData = query.value(0).toByteArray();
+        }
+
+        if (imageData.isEmpty()) {
+            useThumbnail = false;
+        }
+    } else if (useThumbnail) {
+        // 优先使用缩略图数据，提高加载速度（窄表读取，不经过原图的溢出页）
+        CachedStatement query = cachedQuery("SELECT thumbnail FROM image_thumbnails WHERE image_id = ?");
+        query->bindValue(0, id);
+        
+        if (!query.exec()) {
+            return QImage();
+        }
+        
+        if (query.next()) {
+            imageData = query.value(0).toByteArray();
+        } else {
+            // 尚未迁移的旧数据，回退到 images 表中的缩略图
+            CachedStatement legacyQuery = cachedQuery("SELECT thumbnail FROM images WHERE id = ?");
+            legacyQuery->bindValue(0, id);
+            if (!legacyQuery.exec() || !legacyQuery.next()) {
+                return QImage();
+            }
+            imageData = legacyQuery.value(0).toByteArray();
+        }
+        
+        // 如果缩略图不存在，回退到原始图片
+        if (imageData.isEmpty()) {
+            useThumbnail = false;
+        }
+    }
+    
+    if (!useThumbnail) {
+        // 原始图片：格式从元数据窄表读取，数据通过BLOB设备交给解码器（见 BlobReadDevice 的读取方式）
+        {
+            CachedStatement query = cachedQuery(R"(
+                SELECT COALESCE(m.image_format, i.image_format)
+                FROM images i LEFT JOIN image_meta m ON m.image_id = i.id
+                WHERE i.id = ?
+            )");
+            query->bindValue(0, id);
+            if (!query.exec() || !query.next()) {
+                return QImage();
+            }
+            imageFormat = query.value(0).toString();
+        }
+
+        BlobReadDevice device(db, "images", "image_data", id);
+        device.setProfiler(activeQueryProfiler(), IMAGEDB_CALLER_NAME);
+        if (!device.open(QIODevice::ReadOnly)) {
+            return QImage();
+        }
+
+        QImageReader reader(&device, imageFormat.toUtf8());
+        if (timing) {
+            timing->fetchNs = stageTimer.nsecsElapsed();
+            stageTimer.restart();
+        }
+
+        // 只读取文件头获得原图尺寸，再按目标尺寸解码：
+        // JPEG 解码器会直接在 DCT 域按 1/2、1/4、1/8 缩小，省去大部分解码时间和内存
+        QSize fullSize = reader.size();
+        if (originalSize) {
+            *originalSize = fullSize;
+        }
+        if (fullSize.isValid() && (targetSize.width() > 0 || targetSize.height() > 0)) {
+            QSize scaledSize = boundedSize(fullSize, targetSize);
+            if (scaledSize != fullSize) {
+                reader.setScaledSize(scaledSize);
+            }
+        }
+
+        QImage image = reader.read();
+        if (originalSize && !fullSize.isValid()) {
+            *originalSize = image.size();
+        }
+        if (timing) {
+            timing->decodeNs = stageTimer.nsecsElapsed();
+        }
+        return image;
+    }
+    
+    // 缩略图（包括各级多分辨率缩略图）统一使用JPG格式解码
+    if (timing) {
+        timing->fetchNs = stageTimer.nsecsElapsed();
+        stageTimer.restart();
+    }
+    QImage image;
+    image.loadFromData(imageData, "JPG");
+    if (timing) {
+        timing->decodeNs = stageTimer.nsecsElapsed();
+    }
+    
+    return image;
+}
+
+QString Database::getLastError() const
+{
+    return m_lastError;
+}
+
+int Database::getImageByteSize(int imageId)
+{
+    // 优先读取元数据窄表，尚未迁移的旧数据回退到 LENGTH(image_data)
+    CachedStatement query = cachedQuery(R"(
+        SELECT COALESCE(m.byte_size, LENGTH(i.image_data))
+        FROM images i LEFT JOIN image_meta m ON m.image_id = i.id
+        WHERE i.id = ?
+    )");
+    query->bindValue(0, imageId);
+
+    if (!query.exec() || !query.next()) {
+        m_lastError = query->lastError().text();
+        return 0;
+    }
+
+    return query.value(0).toInt();
+}
+
+QVariantMap Database::getImageInfo(int imageId)
+{
+    const QVariantList infos = getImageInfos({ imageId });
+    return infos.isEmpty() ? QVariantMap() : infos.first().toMap();
+}
+
+QVariantList Database::getImageInfos(const QList<int> &imageIds)
+{
+    QVariantList infos;
+
+    // 每条语句最多绑定 500 个ID（低于旧版SQLite的参数数量上限）
+    const int chunkSize = 500;
+    for (int offset = 0; offset < imageIds.size(); offset += chunkSize) {
+        const QList<int> chunk = imageIds.mid(offset, chunkSize);
+        QStringList placeholders;
+        for (int i = 0; i < chunk.size(); i++) {
+            placeholders.append("?");
+        }
+
+        CachedStatement query = cachedQuery(QString(R"(
+            SELECT i.id, i.filename, COALESCE(m.image_format, i.image_format),
+                   COALESCE(m.byte_size, LENGTH(i.image_data)),
+                   COALESCE(m.width, 0), COALESCE(m.height, 0),
+                   COALESCE(m.pixel_format, 0), COALESCE(m.color_depth, 0)
+            FROM images i LEFT JOIN image_meta m ON m.image_id = i.id
+            WHERE i.id IN (%1)
+        )").arg(placeholders.join(", ")), chunk.size() == chunkSize); // 只缓存整块的语句，末尾长度不定的一块不缓存
+        for (int i = 0; i < chunk.size(); i++) {
+            query->bindValue(i, chunk.at(i));
+        }
+
+        if (!query.exec()) {
+            m_lastError = query->lastError().text();
+            return infos;
+        }
+
+        while (query.next()) {
+            QVariantMap info;
+            info.insert("id", query.value(0).toInt());
+            info.insert("filename", query.value(1).toString());
+            info.insert("format", query.value(2).toString());
+            info.insert("byteSize", query.value(3).toLongLong());
+            info.insert("width", query.value(4).toInt());
+            info.insert("height", query.value(5).toInt());
+            info.insert("pixelFormat", query.value(6).toInt());
+            info.insert("colorDepth", query.value(7).toInt());
+            infos.append(info);
+        }
+    }
+
+    return infos;
+}
+
+QString Database::getGroupPath(int groupId)
+{
+    if (groupId <= 0) {
+        return QString();
+    }
+    
+    QStringList pathParts;
+    
+    // 一次查询取出全部祖先（包括自身），按层级从根到当前分组排列
+    CachedStatement query = cachedQuery(R"(
+        SELECT g.name FROM group_closure c
+        JOIN groups g ON g.id = c.ancestor_id
+        WHERE c.descendant_id = ?
+        ORDER BY c.depth DESC
+    )");
+    query->bindValue(0, groupId);
+    
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return QString();
+    }
+    
+    while (query.next()) {
+        pathParts.append(query.value(0).toString());
+    }
+    
+    return pathParts.join("\\");
+}
+
+QList<int> Database::getAllDescendantGroupIds(int groupId)
+{
+    QList<int> descendantIds;
+
+    if (groupId <= 0) {
+        return descendantIds;
+    }
+
+    // 闭包表的索引范围查询：分组自身（depth = 0）及其所有子孙分组
+    CachedStatement query = cachedQuery("SELECT descendant_id FROM group_closure WHERE ancestor_id = ? ORDER BY depth");
+    query->bindValue(0, groupId);
+
+    if (!query.exec()) {
+        m_lastError = query->lastError().text();
+        return descendantIds;
+    }
+
+    // 收集所有分组ID
+    while (query.next()) {
+        descendantIds.append(query.value(0).toInt());
+    }
+
+    return descendantIds;
+}
+
+
+
+// 多个线程共同汇报进度时按时间合并：每个时间间隔内只有一个线程真正发射信号
+class ProgressThrottle
+{
+public:
+    explicit ProgressThrottle(qint64 intervalMs)
+        : m_intervalMs(intervalMs), m_lastReportMs(0)
+    {
+        m_timer.start();
+    }
+
+    bool shouldReport()
+    {
+        const qint64 now = m_timer.elapsed();
+        qint64 last = m_lastReportMs.load();
+        return now - last >= m_intervalMs && m_lastReportMs.compare_exchange_strong(last, now);
+    }
+
+private:
+    QElapsedTimer m_timer;
+    const qint64 m_intervalMs;
+    std::atomic<qint64> m_lastReportMs;
+};
+
+// 在已占用的文件名中为 fileName 找一个不冲突的名字："a.jpg" -> "a (2).jpg" -> "a (3).jpg"...
+// 比较时忽略大小写，导出到不区分大小写的文件系统时同样不会互相覆盖
+static QString uniqueFileName(const QString &fileName, QSet<QString> &usedNames)
+{
+    if (!usedNames.contains(fileName.toLower())) {
+        usedNames.insert(fileName.toLower());
+        return fileName;
+    }
+
+    const QFileInfo info(fileName);
+    const QString baseName = info.completeBaseName();
+    const QString suffix = info.suffix().isEmpty() ? QString() : "." + info.suffix();
+    for (int n = 2; ; ++n) {
+        const QString candidate = QString("%1 (%2)%3").arg(baseName).arg(n).arg(suffix);
+        if (!usedNames.contains(candidate.toLower())) {
+            usedNames.insert(candidate.toLower());
+            return candidate;
+        }
+    }
+}
+
+// 分组名中不能用作文件夹名的字符替换为下划线
+static QString sanitizePathComponent(const QString &name)
+{
+    static const QString invalidChars = QStringLiteral("<>:\"/\\|?*");
+    QString result;
+    result.reserve(name.size());
+    for (const QChar ch : name) {
+        result.append(ch.unicode() < 0x20 || invalidChars.contains(ch) ? QChar('_') : ch);
+    }
+    // Windows 不允许以空格或句点结尾
+    while (result.endsWith(' ') || result.endsWith('.')) {
+        result.chop(1);
+    }
+    return result.isEmpty() ? QStringLiteral("_") : result;
+}
+
+// 把一张图片的原始数据分块写入目标文件（chunk 由调用线程复用）
+static bool writeBlobToFile(const QSqlDatabase &db, int imageId, const QString &targetPath,
+                            QByteArray &chunk, QueryProfiler *profiler, QString *error)
+{
+    // 图片数据通过BLOB设备分块读取，内存占用与图片大小无关
+    BlobReadDevice blob(db, "images", "image_data", imageId);
+    blob.setProfiler(profiler, IMAGEDB_CALLER_NAME);
+    if (!blob.open(QIODevice::ReadOnly)) {
+        *error = QString("无法读取图片 ID: %1").arg(imageId);
+        return false;
+    }
+
+    if (blob.size() == 0) {
+        *error = QString("图片 ID: %1 数据为空").arg(imageId);
+        return false;
+    }
+
+    QFile file(targetPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = QString("无法打开文件: %1").arg(targetPath);
+        return false;
+    }
+
+    qint64 bytesWritten = 0;
+    qint64 bytesRead = 0;
+    while ((bytesRead = blob.read(chunk.data(), chunk.size())) > 0) {
+        if (file.write(chunk.constData(), bytesRead) != bytesRead) {
+            break;
+        }
+        bytesWritten += bytesRead;
+    }
+    file.close();
+
+    if (bytesWritten != blob.size()) {
+        *error = QString("写入文件失败: %1").arg(targetPath);
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+// 异步导出实现
+//
+// 协调线程先用一次查询列出全部图片，并在单线程中确定每张图片不冲突的目标文件名；
+// 随后多个写入线程各自使用自己的连接，从共享的下标中领取图片，经BLOB设备分块写入文件。
+// 进度按时间合并发射，不再逐张发射信号或休眠
+void Database::startAsyncExport(int groupId, const QString &groupName, const QString &targetFolder, bool recursive,
+                                int format, bool writeManifest)
+{
+    if (m_exportWatcher->isRunning()) {
+        emit exportError("已有导出任务正在进行");
+        return;
+    }
+
+    // 重置导出状态
+    m_exportGroupId = groupId;
+    m_exportGroupName = groupName;
+    m_exportTargetFolder = targetFolder;
+    m_exportTotalCount = 0;
+    m_exportSuccessCount = 0;
+    m_exportCancelled = false;
+    
+    auto exportFunction = [this, groupId, groupName, targetFolder, recursive, format, writeManifest]() {
+        try {
+            // 协调线程使用自己的连接，不与主线程共享 m_db
+            QSqlDatabase db = threadConnection();
+            if (!db.isOpen()) {
+                emit exportError("无法打开导出连接: " + db.lastError().text());
+                return false;
+            }
+
+            const QString rootName = sanitizePathComponent(groupName);
+            QStringList directories;
+
+            if (format == ExportToTar || format == ExportToZip) {
+                // 打包导出：归档内的路径以分组名开头，归档文件名不覆盖目标文件夹中已有的文件
+                const QList<ExportItem> items = planGroupExport(groupId, groupName, rootName, recursive,
+                                                                false, &directories);
+                m_exportTotalCount = items.size();
+                if (items.isEmpty()) {
+                    return true;
+                }
+
+                QSet<QString> usedNames;
+                for (const QString &existing : QDir(targetFolder).entryList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
+                    usedNames.insert(existing.toLower());
+                }
+                const QString archiveName = rootName + (format == ExportToZip ? ".zip" : ".tar");
+                const QString archivePath = targetFolder + "/" + uniqueFileName(archiveName, usedNames);
+                m_exportSuccessCount = writeExportArchive(items, archivePath, format, writeManifest, targetFolder);
+                return true;
+            }
+
+            const QString targetDir = targetFolder + "/" + rootName;
+            const QList<ExportItem> items = planGroupExport(groupId, groupName, targetDir, recursive,
+                                                            true, &directories);
+            m_exportTotalCount = items.size();
+            if (items.isEmpty()) {
+                return true;
+            }
+
+            // 第一遍：建立完整的目录结构（包括没有图片的子分组），之后写入线程只需写文件
+            for (const QString &directory : directories) {
+                if (!QDir().mkpath(directory)) {
+                    emit exportError(QString("无法创建目标文件夹: %1").arg(directory));
+                    return false;
+                }
+            }
+
+            m_exportSuccessCount = writeExportItems(items, targetFolder);
+        } catch (const std::exception &e) {
+            emit exportError(QString("导出过程中发生异常: %1").arg(e.what()));
+            return false;
+        } catch (...) {
+            emit exportError("导出过程中发生未知异常");
+            return false;
+        }
+        
+        return true;
+    };
+    
+    // 开始异步导出
+    QFuture<bool> future = QtConcurrent::run(exportFunction);
+    m_exportWatcher->setFuture(future);
+}
+
+QList<ExportItem> Database::planGroupExport(int groupId, const QString &groupName,
+                                            const QString &targetDir, bool recursive, bool avoidExistingFiles,
+                                            QStringList *directories)
+{
+    QList<ExportItem> items;
+    recursive = recursive && groupId > 0;
+
+    // 分组ID -> 目标文件夹和原始分组路径；非递归导出时只有所选分组本身
+    QHash<int, QString> groupDirs;
+    QHash<int, QString> groupPaths;
+    groupDirs.insert(groupId, targetDir);
+    groupPaths.insert(groupId, groupName);
+
+    // 每个目标文件夹中已占用的名字：子分组文件夹和已分配的图片文件名，
+    // 导出到文件夹时还包括磁盘上已有的文件和文件夹（导出不会覆盖任何已有文件）
+    QHash<QString, QSet<QString>> usedNames;
+    auto usedNamesIn = [&usedNames, avoidExistingFiles](const QString &dir) -> QSet<QString> & {
+        auto it = usedNames.find(dir);
+        if (it == usedNames.end()) {
+            QSet<QString> names;
+            if (avoidExistingFiles) {
+                const QStringList existing = QDir(dir).entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+                for (const QString &name : existing) {
+                    names.insert(name.toLower());
+                }
+            }
+            it = usedNames.insert(dir, names);
+        }
+        return it.value();
+    };
+
+    if (recursive) {
+        // 按层级从浅到深读取子孙分组，父分组的文件夹总是先于子分组确定
+        CachedStatement groupQuery = cachedQuery(R"(
+            SELECT g.id, g.parent_id, g.name FROM group_closure c
+            JOIN groups g ON g.id = c.descendant_id
+            WHERE c.ancestor_id = ? AND c.depth > 0
+            ORDER BY c.depth, g.name
+        )");
+        groupQuery->addBindValue(groupId);
+
+        if (!groupQuery.exec()) {
+            emit exportError("无法读取子分组: " + groupQuery->lastError().text());
+            return items;
+        }
+
+        while (groupQuery.next()) {
+            const int parentId = groupQuery.value(1).toInt();
+            const QString parentDir = groupDirs.value(parentId);
+            if (parentDir.isEmpty()) {
+                continue;
+            }
+            // 同名的兄弟分组与图片文件一样按 "名称 (2)" 区分
+            const QString name = groupQuery.value(2).toString();
+            const QString dirName = uniqueFileName(sanitizePathComponent(name), usedNamesIn(parentDir));
+            groupDirs.insert(groupQuery.value(0).toInt(), parentDir + "/" + dirName);
+            groupPaths.insert(groupQuery.value(0).toInt(), groupPaths.value(parentId) + "\\" + name);
+        }
+    }
+
+    *directories = groupDirs.values();
+
+    // 一次查询取得全部图片ID和文件名（非递归时分组条件与 getAllImageIds 相同）
+    const QString columns = "SELECT i.id, i.group_id, i.filename, i.image_format FROM images i";
+    QString sql;
+    if (recursive) {
+        sql = columns + R"(
+            JOIN group_closure c ON i.group_id = c.descendant_id
+            WHERE c.ancestor_id = ?
+            ORDER BY i.group_id, i.id
+        )";
+    } else if (groupId > 0) {
+        sql = columns + " WHERE i.group_id = ? ORDER BY i.id";
+    } else if (groupId == -1) {
+        sql = columns + " WHERE i.group_id IS NULL OR i.group_id = -1 ORDER BY i.id";
+    } else {
+        sql = columns + " ORDER BY i.id";
+    }
+
+    CachedStatement query = cachedQuery(sql);
+    if (recursive || groupId > 0) {
+        query->addBindValue(groupId);
+    }
+
+    if (!query.exec()) {
+        emit exportError("无法读取导出图片列表: " + query->lastError().text());
+        return items;
+    }
+
+    while (query.next()) {
+        const int imageId = query.value(0).toInt();
+        const int imageGroupId = recursive ? query.value(1).toInt() : groupId;
+        const QString dir = groupDirs.value(imageGroupId);
+        if (dir.isEmpty()) {
+            continue;
+        }
+
+        QString fileName = QFileInfo(query.value(2).toString()).fileName();
+        if (fileName.isEmpty()) {
+            fileName = QString("image_%1.%2").arg(imageId).arg(query.value(3).toString().toLower());
+        }
+
+        ExportItem item;
+        item.imageId = imageId;
+        item.targetPath = dir + "/" + uniqueFileName(fileName, usedNamesIn(dir));
+        item.fileName = query.value(2).toString();
+        item.groupPath = groupPaths.value(imageGroupId);
+        items.append(item);
+    }
+
+    return items;
+}
+
+int Database::writeExportItems(const QList<ExportItem> &items, const QString &targetFolder)
+{
+    const int totalCount = items.size();
+    std::atomic<int> nextIndex(0);
+    std::atomic<int> doneCount(0);
+    std::atomic<int> successCount(0);
+    ProgressThrottle throttle(ExportProgressIntervalMs);
+
+    auto writer = [&]() {
+        // 每个写入线程使用自己的连接读取BLOB
+        QSqlDatabase db = threadConnection();
+        QByteArray chunk(BlobChunkSize, Qt::Uninitialized);
+
+        for (int i = nextIndex++; i < totalCount && !m_exportCancelled; i = nextIndex++) {
+            const ExportItem &item = items.at(i);
+            QString error;
+            if (db.isOpen() && writeBlobToFile(db, item.imageId, item.targetPath, chunk, activeQueryProfiler(), &error)) {
+                successCount++;
+            } else {
+                emit exportError(error.isEmpty() ? "无法打开导出连接: " + db.lastError().text() : error);
+            }
+
+            const int done = ++doneCount;
+            if (throttle.shouldReport()) {
+                emit exportProgress(done, totalCount, QFileInfo(item.targetPath).fileName(), targetFolder);
+            }
+        }
+    };
+
+    const int writerCount = qMin(m_exportPool->maxThreadCount(), totalCount);
+    QList<QFuture<void>> writers;
+    for (int i = 0; i < writerCount; ++i) {
+        writers.append(QtConcurrent::run(m_exportPool, writer));
+    }
+    for (QFuture<void> &future : writers) {
+        future.waitForFinished();
+    }
+
+    // 最后一次进度总是发射，界面显示最终计数
+    emit exportProgress(doneCount, totalCount, QFileInfo(items.last().targetPath).fileName(), targetFolder);
+    return successCount;
+}
+
+int Database::writeExportArchive(const QList<ExportItem> &items, const QString &archivePath, int format,
+                                 bool writeManifest, const QString &targetFolder)
+{
+    // 归档只能顺序写入：单个线程依次把每张图片的BLOB分块复制到归档中，内存占用只有一个复制缓冲区
+    QSqlDatabase db = threadConnection();
+    if (!db.isOpen()) {
+        emit exportError("无法打开导出连接: " + db.lastError().text());
+        return 0;
+    }
+
+    ArchiveWriter archive(format == ExportToZip ? ArchiveWriter::Zip : ArchiveWriter::Tar);
+    if (!archive.open(archivePath)) {
+        emit exportError(archive.errorString());
+        return 0;
+    }
+
+    // 创建时间作为条目的修改时间
+    CachedStatement timeQuery = cachedQuery("SELECT created_at FROM images WHERE id = ?");
+
+    // 清单每行一个JSON对象；哈希与导入去重使用的内容哈希相同，重新导入时可以直接比对
+    QByteArray manifest;
+    const int totalCount = items.size();
+    int successCount = 0;
+    ProgressThrottle throttle(ExportProgressIntervalMs);
+
+    for (int i = 0; i < totalCount && !m_exportCancelled; ++i) {
+        const ExportItem &item = items.at(i);
+
+        QDateTime modified = QDateTime::currentDateTime();
+        timeQuery->bindValue(0, item.imageId);
+        if (timeQuery.exec() && timeQuery.next()) {
+            QDateTime createdAt = QDateTime::fromString(timeQuery.value(0).toString(), "yyyy-MM-dd HH:mm:ss");
+            if (createdAt.isValid()) {
+                createdAt.setTimeZone(QTimeZone::UTC); // CURRENT_TIMESTAMP 为UTC时间
+                modified = createdAt;
+            }
+        }
+        timeQuery->finish();
+
+        BlobReadDevice blob(db, "images", "image_data", item.imageId);
+        blob.setProfiler(activeQueryProfiler(), IMAGEDB_CALLER_NAME);
+        if (!blob.open(QIODevice::ReadOnly) || blob.size() == 0) {
+            emit exportError(QString("无法读取图片 ID: %1").arg(item.imageId));
+        } else {
+            QCryptographicHash hash(QCryptographicHash::Blake2b_160);
+            if (archive.addFile(item.targetPath, &blob, blob.size(), modified, writeManifest ? &hash : nullptr)) {
+                successCount++;
+                if (writeManifest) {
+                    QJsonObject entry;
+                    entry.insert("path", item.targetPath);
+                    entry.insert("filename", item.fileName);
+                    entry.insert("group", item.groupPath);
+                    entry.insert("size", blob.size());
+                    entry.insert("blake2b160", QString::fromLatin1(hash.result().toHex()));
+                    manifest += QJsonDocument(entry).toJson(QJsonDocument::Compact);
+                    manifest += '\n';
+                }
+            } else if (!archive.isWritable()) {
+                // 写归档文件失败（如磁盘已满），无法继续
+                emit exportError(archive.errorString());
+                break;
+            } else {
+                emit exportError(QString("图片 ID: %1 %2").arg(item.imageId).arg(archive.errorString()));
+            }
+        }
+
+        if (throttle.shouldReport()) {
+            emit exportProgress(i + 1, totalCount, QFileInfo(item.targetPath).fileName(), targetFolder);
+        }
+    }
+
+    // 取消或写入失败时删除不完整的归档
+    if (m_exportCancelled || !archive.isWritable()) {
+        archive.abort();
+        return 0;
+    }
+
+    if (writeManifest && !archive.addData("manifest.jsonl", manifest, QDateTime::currentDateTime())) {
+        emit exportError(archive.errorString());
+    }
+
+    if (!archive.close()) {
+        emit exportError(archive.errorString());
         return 0;
     }
 
-    if (query.next()) {
-        count = query.value(0).toInt();
+    emit exportProgress(totalCount, totalCount, QFileInfo(archivePath).fileName(), targetFolder);
+    return successCount;
+}
+
+void Database::cancelAsyncExport()
+{
+    m_exportCancelled = true;
+    
+    if (m_exportWatcher && m_exportWatcher->isRunning()) {
+        m_exportWatcher->waitForFinished();
+    }
+}
+
+void Database::onExportFinished()
+{
+    emit exportFinished(!m_exportCancelled, m_exportSuccessCount, m_exportTotalCount, m_exportTargetFolder);
+}
+
+// 异步导入实现
+//
+// 导入流水线分为两个阶段：
+// 1. 准备阶段：m_importPool 中的多个工作线程并行读取文件、解码并生成缩略图（不访问数据库）
+// 2. 写入阶段：单个写入线程独占一个数据库连接，按文件顺序依次写入
+// 主线程只负责接收进度信号，不再参与任何文件或数据库操作
+void Database::startAsyncImport(const QList<QUrl> &fileUrls, int parentGroupId, int duplicateMode)
+{
+    // 重置导入状态
+    m_importFileUrls = fileUrls;
+    m_importParentGroupId = parentGroupId;
+    m_importCurrentIndex = 0;
+    m_importTotalCount = fileUrls.size();
+    m_importSuccessCount = 0;
+    m_importDuplicateCount = 0;
+    m_importCancelled = false;
+    m_importCreatedGroups.clear();
+    
+    if (m_importTotalCount == 0) {
+        emit importFinished(true, 0, 0, 0);
+        return;
+    }
+    
+    // 写入阶段在后台线程执行
+    auto importFunction = [this, fileUrls, parentGroupId, duplicateMode]() {
+        bool result = true;
+
+        try {
+            // 写入阶段独占当前线程的连接
+            QSqlDatabase db = threadConnection();
+            BulkWriteScope bulkWrite(db, m_bulkWriters);
+
+            // 去重：库中已有的哈希一次性载入内存，准备阶段据此跳过解码（只读，工作线程无需加锁）；
+            // 本次导入中的重复文件由写入线程按文件顺序判断，写入成功的第一份认领哈希，
+            // 解码或写入失败的副本不认领，后面相同内容的文件仍会写入
+            const bool skipDuplicates = (duplicateMode == SkipDuplicates);
+            QSet<QByteArray> committedHashes;
+            QSet<QByteArray> pendingHashes; // 已写入当前批次、尚未提交的哈希
+
+            // 在当前批次事务中新建的分组，提交后才通知界面（回滚时分组随之消失）
+            struct PendingGroup
+            {
+                int id;
+                int parentId;
+                QString name;
+            };
+            QList<PendingGroup> pendingGroups;
+            auto announceGroups = [this, &pendingGroups]() {
+                for (const PendingGroup &group : std::as_const(pendingGroups)) {
+                    emit groupAdded(group.id, group.parentId, group.name);
+                }
+                pendingGroups.clear();
+            };
+            // 批次回滚：撤销本批新建分组的缓存，后续同名文件夹重新创建
+            auto discardGroups = [this, &pendingGroups]() {
+                for (const PendingGroup &group : std::as_const(pendingGroups)) {
+                    for (auto it = m_importCreatedGroups.begin(); it != m_importCreatedGroups.end();) {
+                        it = (it.value() == group.id) ? m_importCreatedGroups.erase(it) : std::next(it);
+                    }
+                }
+                pendingGroups.clear();
+            };
+
+            // 写入器析构时可能提交，需在上面的哈希集合和分组列表之后创建
+            ImageBatchWriter writer(db);
+            writer.setProfiler(activeQueryProfiler());
+
+            // 每批提交后先通知新建的分组，再通知列表模型增量插入（跨线程排队发射），本批的哈希转为已提交
+            writer.setCommitCallback([this, &committedHashes, &pendingHashes, &announceGroups](const QList<int> &imageIds) {
+                committedHashes.unite(pendingHashes);
+                pendingHashes.clear();
+                m_importSuccessCount += imageIds.size();
+                announceGroups();
+                emit imagesChanged(imageIds);
+            });
+            if (!db.isOpen()) {
+                emit importError("Failed to open import connection: " + db.lastError().text());
+                result = false;
+            } else {
+                if (skipDuplicates) {
+                    // 只与已有的哈希比较；旧图片的哈希由启动时的后台任务补算，补算完成前无法识别与它们重复
+                    CachedStatement hashQuery = cachedQuery("SELECT content_hash FROM image_hashes");
+                    if (hashQuery.exec()) {
+                        while (hashQuery.next()) {
+                            committedHashes.insert(hashQuery.value(0).toByteArray());
+                        }
+                    }
+                }
+                // 准备阶段只与导入开始前已在库中的哈希比较
+                const QSet<QByteArray> existingHashes = committedHashes;
+                auto isDuplicate = [&existingHashes](const QByteArray &hash) {
+                    return existingHashes.contains(hash);
+                };
+
+                // 已准备好、等待写入的记录。先在事务外攒够一批，再在一次短事务中写入并提交，
+                // 等待解码期间不持有写锁，界面线程的单条写入（重命名、移动等）不会被阻塞
+                QList<ImageRecord> readyRecords;
+                qint64 readyBytes = 0;
+                auto writeReadyRecords = [&]() {
+                    for (ImageRecord &record : readyRecords) {
+                        // 与本次导入中已写入的文件重复（准备阶段无法判断，只能在这里按顺序处理）
+                        if (skipDuplicates
+                            && (committedHashes.contains(record.contentHash) || pendingHashes.contains(record.contentHash))) {
+                            m_importDuplicateCount++;
+                            continue;
+                        }
+
+                        bool groupCreated = false;
+                        record.groupId = resolveImportGroup(record.folderName, parentGroupId, &groupCreated);
+                        if (groupCreated) {
+                            const PendingGroup group{record.groupId, parentGroupId > 0 ? parentGroupId : -1, record.folderName};
+                            if (writer.inTransaction()) {
+                                pendingGroups.append(group);
+                            } else {
+                                // 不在批次事务中，插入已自动提交
+                                emit groupAdded(group.id, group.parentId, group.name);
+                            }
+                        }
+                        // 写入前先认领：add 达到批次阈值时会在内部提交，回调把本批哈希转为已提交
+                        if (skipDuplicates) {
+                            pendingHashes.insert(record.contentHash);
+                        }
+                        if (!writer.add(record)) {
+                            // 提交失败时整批回滚，本批认领的哈希一并作废；否则只撤销这一条
+                            if (!writer.inTransaction()) {
+                                pendingHashes.clear();
+                                discardGroups();
+                            } else {
+                                pendingHashes.remove(record.contentHash);
+                            }
+                            emit importError("Failed to import image: " + record.filePath + ", Error: " + writer.lastError());
+                        }
+                    }
+                    readyRecords.clear();
+                    readyBytes = 0;
+
+                    // 成功数在提交回调中累计
+                    if (!writer.commit()) {
+                        pendingHashes.clear();
+                        discardGroups();
+                        emit importError("Failed to commit imported images: " + writer.lastError());
+                        return false;
+                    }
+                    // 批次内的图片全部写入失败时没有提交回调，分组本身已提交
+                    announceGroups();
+                    return true;
+                };
+
+                const int totalCount = fileUrls.size();
+                // 同时处于准备阶段的文件数量上限，限制内存中缓存的原始数据量
+                const int maxInFlight = qMax(2, m_importPool->maxThreadCount() * 2);
+                QQueue<QFuture<ImageRecord>> inFlight;
+                int submitted = 0;
+
+                for (int i = 0; i < totalCount; ++i) {
+                    // 补充准备任务，保持工作线程满载
+                    while (submitted < totalCount && inFlight.size() < maxInFlight && !m_importCancelled) {
+                        const QUrl fileUrl = fileUrls[submitted++];
+                        inFlight.enqueue(QtConcurrent::run(m_importPool, [this, fileUrl, skipDuplicates, &isDuplicate]() {
+                            if (m_importCancelled) {
+                                ImageRecord cancelled;
+                                cancelled.error = "Import cancelled";
+                                return cancelled;
+                            }
+                            if (skipDuplicates) {
+                                return prepareImageRecord(fileUrl, isDuplicate);
+                            }
+                            return prepareImageRecord(fileUrl);
+                        }));
+                    }
+
+                    if (m_importCancelled || inFlight.isEmpty()) {
+                        break;
+                    }
+
+                    // 按提交顺序取回结果，保证图片ID顺序与文件顺序一致
+                    ImageRecord record = inFlight.dequeue().result();
+                    if (m_importCancelled) {
+                        break;
+                    }
+
+                    const QString fileName = record.fileName;
+                    const QString folderName = record.folderName;
+                    if (record.duplicate) {
+                        m_importDuplicateCount++;
+                    } else if (!record.isValid()) {
+                        emit importError("Failed to import image: " + record.filePath + ", Error: " + record.error);
+                    } else {
+                        readyBytes += ImageBatchWriter::recordBytes(record);
+                        readyRecords.append(std::move(record));
+                    }
+
+                    // 发送进度更新信号
+                    emit importProgress(i + 1, totalCount, fileName, folderName);
+
+                    // 攒够一批（与写入器的提交阈值相同）后集中写入
+                    if (readyRecords.size() >= ImageBatchWriter::DefaultMaxRows
+                        || readyBytes >= ImageBatchWriter::DefaultMaxBytes) {
+                        if (!writeReadyRecords()) {
+                            result = false;
+                        }
+                    }
+                }
+
+                // 取消时等待仍在运行的准备任务结束（未开始的任务会立即返回）
+                while (!inFlight.isEmpty()) {
+                    inFlight.dequeue().waitForFinished();
+                }
+
+                // 写入最后一个不完整的批次（取消时已准备好的图片同样写入）
+                if (!writeReadyRecords()) {
+                    result = false;
+                }
+            }
+        } catch (const std::exception &e) {
+            QString error = "Exception in import thread: " + QString::fromStdString(e.what());
+            emit importError(error);
+            result = false;
+        } catch (...) {
+            emit importError("Unknown exception in import thread");
+            result = false;
+        }
+
+        return result && !m_importCancelled;
+    };
+    
+    // 启动异步导入
+    m_importWatcher->setFuture(QtConcurrent::run(importFunction));
+}
+
+bool Database::backfillContentHashes()
+{
+    // 为旧版本导入、尚无哈希的图片补算哈希（每张只需计算一次）；中断后下次启动从未补算的图片继续
+    QSqlDatabase db = threadConnection();
+    if (!db.isOpen()) {
+        return false;
     }
 
-    return count;
-}
+    CachedStatement idQuery = cachedQuery(R"(
+        SELECT i.id FROM images i
+        WHERE i.id > ? AND NOT EXISTS (SELECT 1 FROM image_hashes h WHERE h.image_id = i.id)
+        ORDER BY i.id LIMIT 100
+    )");
+    CachedStatement insertQuery = cachedQuery("INSERT OR REPLACE INTO image_hashes (image_id, content_hash) VALUES (?, ?)");
 
-QImage Database::getImageAsQImage(int id, bool useThumbnail)
-{
-    QSqlQuery query;
-    QByteArray imageData;
-    QString imageFormat;
-    
-    if (useThumbnail) {
-        // 优先使用缩略图数据，提高加载速度
-        query.prepare("SELECT thumbnail, image_format FROM images WHERE id = ?");
-        query.addBindValue(id);
-        
-        if (!query.exec() || !query.next()) {
-            return QImage();
+    int lastId = 0;
+    while (!m_shuttingDown) {
+        idQuery->bindValue(0, lastId);
+        if (!idQuery.exec()) {
+            qWarning() << "Content hash backfill failed:" << idQuery->lastError().text();
+            return false;
         }
-        
-        imageData = query.value(0).toByteArray();
-        imageFormat = query.value(1).toString();
-        
-        // 如果缩略图不存在，回退到原始图片
-        if (imageData.isEmpty()) {
-            useThumbnail = false;
+        QList<int> batch;
+        while (idQuery.next()) {
+            batch.append(idQuery.value(0).toInt());
         }
-    }
-    
-    if (!useThumbnail) {
-        // 获取原始图片
-        query.prepare("SELECT image_data, image_format FROM images WHERE id = ?");
-        query.addBindValue(id);
-        if (!query.exec() || !query.next()) {
-            return QImage();
+        idQuery->finish();
+
+        if (batch.isEmpty()) {
+            cachedQuery(QString("PRAGMA user_version = %1").arg(SchemaVersionContentHashes), false).exec();
+            qDebug() << "Content hash backfill completed";
+            return true;
         }
-        
-        imageData = query.value(0).toByteArray();
-        imageFormat = query.value(1).toString();
+
+        // 按块读取原图计算哈希（与 computeContentHash 相同的算法），写事务只包含插入
+        QList<QPair<int, QByteArray>> hashes;
+        for (int imageId : batch) {
+            if (m_shuttingDown) {
+                break;
+            }
+            lastId = imageId;
+
+            BlobReadDevice device(db, "images", "image_data", imageId);
+            device.setProfiler(activeQueryProfiler(), IMAGEDB_CALLER_NAME);
+            if (!device.open(QIODevice::ReadOnly)) {
+                continue;
+            }
+            QCryptographicHash hash(QCryptographicHash::Blake2b_160);
+            if (hash.addData(&device)) {
+                hashes.append(qMakePair(imageId, hash.result()));
+            }
+        }
+
+        if (hashes.isEmpty()) {
+            continue;
+        }
+
+        db.transaction();
+        for (const auto &item : hashes) {
+            insertQuery->bindValue(0, item.first);
+            insertQuery->bindValue(1, item.second);
+            if (!insertQuery.exec()) {
+                qWarning() << "Content hash backfill failed:" << insertQuery->lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+        db.commit();
     }
-    
-    // 从字节数组创建QImage
-    QImage image;
-    // 缩略图统一使用JPG格式解码，原始图片使用实际格式解码
-    QString decodeFormat = useThumbnail ? "JPG" : imageFormat;
-    image.loadFromData(imageData, decodeFormat.toUtf8());
-    
-    return image;
+    return false;
 }
 
-QString Database::getLastError() const
+QString Database::importFolderName(const QUrl &fileUrl)
 {
-    return m_lastError;
+    // 提取文件夹名
+    QString folderName = "默认分组";
+    QString urlString = fileUrl.toString();
+    int lastSeparatorIndex = std::max(urlString.lastIndexOf("\\"), urlString.lastIndexOf("/"));
+    if (lastSeparatorIndex != -1) {
+        QString filePath = urlString.left(lastSeparatorIndex);
+        int folderSeparatorIndex = std::max(filePath.lastIndexOf("\\"), filePath.lastIndexOf("/"));
+        if (folderSeparatorIndex != -1) {
+            folderName = QUrl::fromPercentEncoding(filePath.mid(folderSeparatorIndex + 1).toUtf8());
+        } else {
+            folderName = QUrl::fromPercentEncoding(filePath.toUtf8());
+        }
+    }
+    return folderName;
 }
 
-int Database::getImageByteSize(int imageId)
+QSqlDatabase Database::threadConnection()
 {
-    QSqlQuery query;
-    query.prepare("SELECT LENGTH(image_data) FROM images WHERE id = ?");
-    query.addBindValue(imageId);
+    // 主线程直接使用主连接
+    if (QThread::currentThread() == thread()) {
+        return m_db;
+    }
 
-    if (!query.exec() || !query.next()) {
-        m_lastError = query.lastError().text();
-        return 0;
+    if (!m_threadConnections.hasLocalData()) {
+        static std::atomic<int> connectionCounter(0);
+        const QString name = QString("ImageDBManager_pool_%1").arg(++connectionCounter);
+
+        // 复制主连接的配置（按名称复制是线程安全的），连接只在当前线程创建和使用
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(m_db.connectionName(), name);
+        if (db.open()) {
+            QString error;
+            if (!applyConnectionPragmas(db, 4000, &error)) {
+                qWarning() << "Failed to configure pooled connection" << name << ":" << error;
+            }
+        } else {
+            qWarning() << "Failed to open pooled connection" << name << ":" << db.lastError().text();
+        }
+        m_threadConnections.setLocalData(new PooledConnection(name, m_pooledConnections));
     }
 
-    return query.value(0).toInt();
+    return QSqlDatabase::database(m_threadConnections.localData()->name(), false);
 }
 
-QString Database::getGroupPath(int groupId)
+CachedStatement Database::cachedQuery(const QString &sql, bool cache, const char *caller)
 {
-    if (groupId <= 0) {
-        return QString();
+    cache = cache && m_statementCacheEnabled;
+    auto acquire = [&]() {
+        if (QThread::currentThread() == thread()) {
+            return m_statementCache.acquire(m_db, sql, cache);
+        }
+
+        // threadConnection() 保证当前线程的连接已经创建
+        QSqlDatabase db = threadConnection();
+        return m_threadConnections.localData()->statements().acquire(db, sql, cache);
+    };
+
+    CachedStatement statement = acquire();
+    if (m_queryProfilingEnabled) {
+        statement.setProfiler(&m_queryProfiler, caller);
     }
-    
-    QStringList pathParts;
-    int currentId = groupId;
-    
-    // 从当前分组向上查询，直到根节点
-    while (currentId > 0) {
-        QSqlQuery query;
-        query.prepare("SELECT name, parent_id FROM groups WHERE id = ?");
-        query.addBindValue(currentId);
-        
-        if (!query.exec() || !query.next()) {
-            m_lastError = query.lastError().text();
-            break;
+    return statement;
+}
+
+void Database::setQueryProfilingEnabled(bool enabled, int dumpIntervalMs)
+{
+    m_queryProfilingEnabled = enabled;
+    if (enabled && dumpIntervalMs > 0) {
+        m_queryProfileTimer->start(dumpIntervalMs);
+    } else {
+        m_queryProfileTimer->stop();
+    }
+}
+
+void Database::onQueryProfileDump()
+{
+    qInfo().noquote() << m_queryProfiler.report(QueryProfileDumpStatements);
+}
+
+bool Database::applyConnectionPragmas(QSqlDatabase &db, int cacheSizePages, QString *error)
+{
+    const QStringList pragmas = {
+        "PRAGMA foreign_keys = ON",                          // 外键约束
+        QString("PRAGMA cache_size = %1").arg(cacheSizePages), // 页缓存大小
+        "PRAGMA temp_store = MEMORY",                        // 使用内存作为临时存储
+        "PRAGMA mmap_size = 536870912",                      // 内存映射512MB（适合千张以上图片的大数据库场景）
+        // 交互写入（重命名、移动等）单条提交，FULL 保证返回时已落盘；批量导入期间由 BulkWriteScope 改为 NORMAL
+        "PRAGMA synchronous = FULL",
+        // 检查点由后台调度执行，自动检查点只作为调度跟不上时的兜底（约128MB，8KB页）
+        QString("PRAGMA wal_autocheckpoint = %1").arg(WalAutoCheckpointPages),
+        // WAL 重置时截断到该大小以内，大批量导入后不长期占用磁盘
+        QString("PRAGMA journal_size_limit = %1").arg(JournalSizeLimitBytes)
+    };
+
+    QSqlQuery query(db);
+    for (const QString &pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            if (error) {
+                *error = query.lastError().text();
+            }
+            return false;
         }
-        
-        QString name = query.value(0).toString();
-        pathParts.prepend(name);
-        
-        currentId = query.value(1).toInt();
     }
-    
-    return pathParts.join("\\");
+
+    return true;
 }
 
-QList<int> Database::getAllDescendantGroupIds(int groupId)
+qint64 Database::walFileSize() const
 {
-    QList<int> descendantIds;
+    QFileInfo info(m_walPath);
+    return info.exists() ? info.size() : 0;
+}
 
-    if (groupId <= 0) {
-        return descendantIds;
+void Database::onMaintenanceTimer()
+{
+    if (m_maintenanceRunning || !m_db.isOpen()) {
+        return;
     }
 
-    QSqlQuery query;
+    auto startTask = [this](std::function<void()> task) {
+        m_maintenanceRunning = true;
+        m_maintenancePool->start([this, task]() {
+            task();
+            m_maintenanceRunning = false;
+        });
+    };
 
-    // 使用递归CTE查询获取分组及其所有子孙分组ID
-    QString groupQuery = QString(R"(
-        WITH RECURSIVE all_groups AS (
-            SELECT id FROM groups WHERE id = %1
-            UNION ALL
-            SELECT g.id FROM groups g
-            JOIN all_groups ag ON g.parent_id = ag.id
-        )
-        SELECT id FROM all_groups
-    )").arg(groupId);
+    const qint64 walBytes = walFileSize();
+    const bool growing = walBytes != m_lastWalBytes;
+    m_lastWalBytes = walBytes;
 
-    if (!query.exec(groupQuery)) {
-        m_lastError = query.lastError().text();
-        return descendantIds;
+    if (m_bulkWriters > 0) {
+        // 批量写入期间不等待空闲，只防止 WAL 无限增长拖慢读取；后台整理推迟到写入结束后
+        if (walBytes >= BulkCheckpointThresholdBytes) {
+            startTask([this, walBytes]() { runCheckpoint(walBytes); });
+        }
+        return;
     }
 
-    // 收集所有分组ID
-    while (query.next()) {
-        descendantIds.append(query.value(0).toInt());
+    // 一个周期内 WAL 仍在增长说明还有写入，等下一个空闲周期
+    if (growing) {
+        return;
     }
 
-    return descendantIds;
+    bool checkpointed = false;
+    qint64 lastOptimizeTime = 0;
+    {
+        QMutexLocker locker(&m_maintenanceMutex);
+        // 已经全部写回的 WAL 不重复执行
+        checkpointed = walBytes <= 0 || m_walStats.checkpointedWalBytes == walBytes;
+        lastOptimizeTime = m_storageStats.lastOptimizeTime;
+    }
+    if (!checkpointed) {
+        startTask([this, walBytes]() { runCheckpoint(walBytes); });
+        return;
+    }
+
+    // WAL 已写回：按需整理存储（删除后释放空闲页、定期更新统计信息）
+    const bool optimizeDue = QDateTime::currentMSecsSinceEpoch() - lastOptimizeTime >= OptimizeIntervalMs;
+    if (m_storageMaintenanceRequested || optimizeDue) {
+        m_storageMaintenanceRequested = false;
+        startTask([this, optimizeDue]() { runStorageMaintenance(optimizeDue); });
+    }
 }
 
+void Database::runCheckpoint(qint64 walBytes)
+{
+    QSqlDatabase db = threadConnection();
+    if (!db.isOpen()) {
+        return;
+    }
+
+    // PASSIVE 不等待读写连接：只写回当前没有读取者需要的帧，界面读取和导入写入都不会被阻塞
+    QElapsedTimer timer;
+    timer.start();
+    int walFrames = -1;
+    int checkpointedFrames = -1;
+    {
+        CachedStatement query = cachedQuery("PRAGMA wal_checkpoint(PASSIVE)");
+        if (!query.exec() || !query.next()) {
+            qWarning() << "WAL checkpoint failed:" << query->lastError().text();
+            return;
+        }
+        walFrames = query.value(1).toInt();
+        checkpointedFrames = query.value(2).toInt();
+    }
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    {
+        QMutexLocker locker(&m_maintenanceMutex);
+        m_walStats.checkpointCount++;
+        m_walStats.lastCheckpointMs = elapsedMs;
+        m_walStats.maxCheckpointMs = qMax(m_walStats.maxCheckpointMs, elapsedMs);
+        m_walStats.walFrames = walFrames;
+        m_walStats.checkpointedFrames = checkpointedFrames;
+        m_walStats.checkpointedWalBytes = (walFrames >= 0 && checkpointedFrames == walFrames) ? walBytes : -1;
+    }
 
+    qDebug() << "WAL checkpoint:" << walBytes << "bytes," << checkpointedFrames << "/" << walFrames
+             << "frames in" << elapsedMs << "ms";
+    emit walCheckpointed(walBytes, walFrames, checkpointedFrames, elapsedMs);
+}
 
-// 异步导出实现
-void Database::startAsyncExport(int groupId, const QString &groupName, const QString &targetFolder)
+void Database::runStorageMaintenance(bool optimize)
 {
-    // 获取分组内的所有图片ID
-    QList<int> imageIds = getAllImageIds(groupId);
-    int totalCount = imageIds.size();
-    
-    if (totalCount == 0) {
-        emit exportFinished(true, 0, 0, targetFolder);
+    QSqlDatabase db = threadConnection();
+    if (!db.isOpen()) {
         return;
     }
-    
-    // 重置导出状态
-    m_exportGroupId = groupId;
-    m_exportGroupName = groupName;
-    m_exportTargetFolder = targetFolder;
-    m_exportImageIds = imageIds;
-    m_exportCurrentIndex = 0;
-    m_exportTotalCount = totalCount;
-    m_exportSuccessCount = 0;
-    m_exportCancelled = false;
-    
-    // 使用QtConcurrent在后台线程执行导出（流式处理）
-    auto exportFunction = [this, imageIds, totalCount, groupName, targetFolder]() {
-        try {
-            int successCount = 0;
-            
-            for (int i = 0; i < totalCount; ++i) {
-                if (m_exportCancelled) {
+
+    QElapsedTimer timer;
+    timer.start();
+    int freedPages = 0;
+
+    // 单值 PRAGMA 的结果，失败时返回 -1
+    auto pragmaValue = [this](const char *pragma) -> int {
+        CachedStatement query = cachedQuery(pragma);
+        return query.exec() && query.next() ? query.value(0).toInt() : -1;
+    };
+
+    // 增量清理只在 auto_vacuum = INCREMENTAL（2）时有效，旧数据库需要先重建
+    const int autoVacuum = pragmaValue("PRAGMA auto_vacuum");
+
+    if (autoVacuum == 2) {
+        int freelistCount = 0;
+        bool failed = false;
+        while (!m_shuttingDown) {
+            freelistCount = pragmaValue("PRAGMA freelist_count");
+            if (freelistCount < 0) {
+                failed = true;
+                break;
+            }
+
+            // 开始批量写入或达到单次上限时停止，剩余的空闲页留给下一个空闲周期
+            if (freelistCount == 0 || m_bulkWriters > 0 || freedPages >= MaxVacuumPagesPerPass) {
+                break;
+            }
+
+            // 每一步是一个独立的小事务，写锁只被短暂占用
+            const int step = qMin(IncrementalVacuumStepPages, freelistCount);
+            {
+                // PRAGMA 的参数不能绑定，步长变化时不缓存
+                CachedStatement query = cachedQuery(QString("PRAGMA incremental_vacuum(%1)").arg(step), false);
+                if (!query.exec()) {
+                    qWarning() << "Incremental vacuum failed:" << query->lastError().text();
+                    failed = true;
                     break;
                 }
-                
-                int imageId = imageIds[i];
-                
-                // 在后台线程中逐张从数据库查询图片数据
-                QString filename;
-                QByteArray imageData;
-                
-                {
-                    QSqlQuery query(m_db);
-                    query.prepare("SELECT image_data, filename FROM images WHERE id = ?");
-                    query.addBindValue(imageId);
-                    
-                    if (!query.exec() || !query.next()) {
-                        emit exportError(QString("无法读取图片 ID: %1").arg(imageId));
-                        continue;
-                    }
-                    
-                    imageData = query.value(0).toByteArray();
-                    filename = query.value(1).toString();
-                }
-                
-                if (imageData.isEmpty()) {
-                    emit exportError(QString("图片 ID: %1 数据为空").arg(imageId));
-                    continue;
-                }
-                
-                // 构建完整的目标文件路径
-                QString targetFilePath = targetFolder + "/" + groupName + "/" + filename;
-                
-                // 确保目标文件夹存在
-                QString targetDir = QFileInfo(targetFilePath).absolutePath();
-                QDir dir;
-                if (!dir.exists(targetDir)) {
-                    if (!dir.mkpath(targetDir)) {
-                        emit exportError(QString("无法创建目标文件夹: %1").arg(targetDir));
-                        return false;
-                    }
-                }
-                
-                // 写入图片数据到文件
-                QFile file(targetFilePath);
-                if (file.open(QIODevice::WriteOnly)) {
-                    qint64 bytesWritten = file.write(imageData);
-                    file.close();
-                    
-                    if (bytesWritten == imageData.size()) {
-                        successCount++;
-                    } else {
-                        emit exportError(QString("写入文件失败: %1").arg(filename));
-                    }
-                } else {
-                    emit exportError(QString("无法打开文件: %1").arg(filename));
+                while (query.next()) {
                 }
-                
-                // 发出进度信号
-                emit exportProgress(i + 1, totalCount, filename, targetFolder);
-                
-                // 短暂延迟，避免UI卡顿
-                QThread::msleep(10);
             }
-            
-            // 更新成功计数
-            m_exportSuccessCount = successCount;
-        } catch (const std::exception &e) {
-            emit exportError(QString("导出过程中发生异常: %1").arg(e.what()));
-            return false;
-        } catch (...) {
-            emit exportError("导出过程中发生未知异常");
-            return false;
+            freedPages += step;
+            QThread::msleep(IncrementalVacuumPauseMs);
         }
-        
-        return true;
+        if (freelistCount > 0 && !failed && !m_shuttingDown) {
+            m_storageMaintenanceRequested = true;
+        }
+    }
+
+    bool optimized = false;
+    if (optimize && !m_shuttingDown) {
+        // 从未分析过的数据库先 ANALYZE 一次，之后由 PRAGMA optimize 只更新统计信息过期的表
+        // （0x10002：检查所有表，而不只是当前连接用过的表）。采样行数由 analysis_limit 限制
+        bool analyzed = false;
+        {
+            CachedStatement query = cachedQuery("SELECT 1 FROM sqlite_master WHERE name = 'sqlite_stat1'");
+            analyzed = query.exec() && query.next();
+        }
+        CachedStatement limitQuery = cachedQuery(QString("PRAGMA analysis_limit = %1").arg(AnalysisLimit));
+        CachedStatement optimizeQuery = cachedQuery(analyzed ? "PRAGMA optimize = 0x10002" : "ANALYZE");
+        optimized = limitQuery.exec() && optimizeQuery.exec();
+        if (!optimized) {
+            qWarning() << "Failed to update query statistics:" << limitQuery->lastError().text()
+                       << optimizeQuery->lastError().text();
+        }
+    }
+
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+    {
+        QMutexLocker locker(&m_maintenanceMutex);
+        m_storageStats.lastFreedPages = freedPages;
+        m_storageStats.lastMaintenanceMs = elapsedMs;
+        if (optimize) {
+            // 失败时同样推迟到下一个间隔，不在每个空闲周期重试
+            m_storageStats.lastOptimizeTime = QDateTime::currentMSecsSinceEpoch();
+        }
+    }
+
+    if (freedPages > 0 || optimized) {
+        qDebug() << "Storage maintenance: freed" << freedPages << "pages, statistics"
+                 << (optimized ? "updated" : "unchanged") << "in" << elapsedMs << "ms";
+    }
+    emit storageMaintenanceFinished(freedPages, optimized, elapsedMs);
+}
+
+QVariantMap Database::getStorageStatus()
+{
+    QVariantMap status;
+    auto pragmaValue = [this](const char *pragma) -> qint64 {
+        CachedStatement query = cachedQuery(pragma);
+        return query.exec() && query.next() ? query.value(0).toLongLong() : 0;
     };
-    
-    // 开始异步导出
-    QFuture<bool> future = QtConcurrent::run(exportFunction);
-    m_exportWatcher->setFuture(future);
+
+    const qint64 pageSize = pragmaValue("PRAGMA page_size");
+    const qint64 pageCount = pragmaValue("PRAGMA page_count");
+    const qint64 freelistCount = pragmaValue("PRAGMA freelist_count");
+    const int autoVacuum = int(pragmaValue("PRAGMA auto_vacuum")); // 0 NONE, 1 FULL, 2 INCREMENTAL
+
+    status.insert("pageSize", pageSize);
+    status.insert("pageCount", pageCount);
+    status.insert("freelistCount", freelistCount);
+    status.insert("fileBytes", QFileInfo(m_db.databaseName()).size());
+    status.insert("freeBytes", freelistCount * pageSize);
+    status.insert("fragmentation", pageCount > 0 ? double(freelistCount) / pageCount : 0.0);
+    status.insert("autoVacuum", autoVacuum);
+    status.insert("needsRebuild", pageSize != DatabasePageSize || autoVacuum != 2);
+    status.insert("rebuildPending", getSetting(StorageRebuildSettingKey) == "1");
+
+    QMutexLocker locker(&m_maintenanceMutex);
+    status.insert("lastFreedPages", m_storageStats.lastFreedPages);
+    status.insert("lastMaintenanceMs", m_storageStats.lastMaintenanceMs);
+    status.insert("lastOptimizeTime", m_storageStats.lastOptimizeTime);
+    return status;
 }
 
-void Database::cancelAsyncExport()
+void Database::requestStorageMaintenance()
 {
-    m_exportCancelled = true;
-    
-    if (m_exportWatcher && m_exportWatcher->isRunning()) {
-        m_exportWatcher->waitForFinished();
+    m_storageMaintenanceRequested = true;
+}
+
+bool Database::requestStorageRebuild()
+{
+    return saveSetting(StorageRebuildSettingKey, "1");
+}
+
+bool Database::rebuildStorage()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QSqlQuery query;
+
+    int oldPageSize = 0;
+    if (query.exec("PRAGMA page_size") && query.next()) {
+        oldPageSize = query.value(0).toInt();
+    }
+    query.finish();
+
+    // WAL 模式下页大小不能修改，先切换到回滚日志；其他连接打开时无法离开 WAL 模式
+    bool success = query.exec("PRAGMA journal_mode = DELETE") && query.next()
+                   && query.value(0).toString().compare("delete", Qt::CaseInsensitive) == 0;
+    if (!success) {
+        m_lastError = query.lastError().isValid() ? query.lastError().text()
+                                                  : "Cannot leave WAL mode while other connections are open";
+    }
+    query.finish();
+
+    // 重建使用的临时数据库与原库一样大，不能放在内存中
+    const QStringList pragmas = {
+        QString("PRAGMA page_size = %1").arg(DatabasePageSize),
+        "PRAGMA auto_vacuum = INCREMENTAL",
+        "PRAGMA temp_store = FILE"
+    };
+    for (const QString &pragma : pragmas) {
+        if (!success) {
+            break;
+        }
+        if (!query.exec(pragma)) {
+            m_lastError = query.lastError().text();
+            success = false;
+        }
+    }
+
+    if (success && !query.exec("VACUUM")) {
+        m_lastError = query.lastError().text();
+        success = false;
+    }
+
+    // 无论成功与否都恢复运行时的配置
+    query.exec("PRAGMA temp_store = MEMORY");
+    query.exec("PRAGMA journal_mode = WAL");
+    query.finish();
+
+    if (success) {
+        qDebug() << "Database rebuilt in" << timer.elapsed() << "ms, page size" << oldPageSize
+                 << "->" << DatabasePageSize;
     }
+    return success;
 }
 
-void Database::onExportFinished()
+QVariantMap Database::getWalStatus()
 {
-    emit exportFinished(!m_exportCancelled, m_exportSuccessCount, m_exportTotalCount, m_exportTargetFolder);
+    QVariantMap status;
+    status.insert("walBytes", walFileSize());
+    status.insert("bulkWriting", m_bulkWriters > 0);
+
+    QMutexLocker locker(&m_maintenanceMutex);
+    status.insert("checkpointCount", m_walStats.checkpointCount);
+    status.insert("lastCheckpointMs", m_walStats.lastCheckpointMs);
+    status.insert("maxCheckpointMs", m_walStats.maxCheckpointMs);
+    status.insert("walFrames", m_walStats.walFrames);
+    status.insert("checkpointedFrames", m_walStats.checkpointedFrames);
+    return status;
 }
 
-// 异步导入实现
-void Database::startAsyncImport(const QList<QUrl> &fileUrls, int parentGroupId)
+int Database::resolveImportGroup(const QString &folderName, int parentGroupId, bool *created)
 {
-    // 重置导入状态
-    m_importFileUrls = fileUrls;
-    m_importParentGroupId = parentGroupId;
-    m_importCurrentIndex = 0;
-    m_importTotalCount = fileUrls.size();
-    m_importSuccessCount = 0;
-    m_importCancelled = false;
-    m_importCreatedGroups.clear();
-    
-    if (m_importTotalCount == 0) {
-        emit importFinished(true, 0, 0);
-        return;
+    if (created) {
+        *created = false;
     }
-    
-    // 使用QtConcurrent在后台线程执行导入
-    auto importFunction = [this, parentGroupId]() {
-        try {
-            for (int i = 0; i < m_importTotalCount; ++i) {
-                if (m_importCancelled) {
-                    break;
-                }
-                
-                const QUrl &fileUrl = m_importFileUrls[i];
-                QString fileName = fileUrl.toLocalFile();
-                
-                // 提取文件夹名
-                QString folderName = "默认分组";
-                QString urlString = fileUrl.toString();
-                int lastSeparatorIndex = std::max(urlString.lastIndexOf("\\"), urlString.lastIndexOf("/"));
-                if (lastSeparatorIndex != -1) {
-                    QString filePath = urlString.left(lastSeparatorIndex);
-                    int folderSeparatorIndex = std::max(filePath.lastIndexOf("\\"), filePath.lastIndexOf("/"));
-                    if (folderSeparatorIndex != -1) {
-                        folderName = QUrl::fromPercentEncoding(filePath.mid(folderSeparatorIndex + 1).toUtf8());
-                    } else {
-                        folderName = QUrl::fromPercentEncoding(filePath.toUtf8());
-                    }
-                }
-                
-                // 准备分组
-                QString groupKey = QString("%1:%2").arg(parentGroupId).arg(folderName);
-                int targetGroupId = parentGroupId;
-                
-                // 在主线程中执行数据库操作，确保线程安全
-                QMetaObject::invokeMethod(this, [this, folderName, parentGroupId, groupKey, &targetGroupId]() {
-                    // 检查是否已经创建过该分组
-                    if (!m_importCreatedGroups.contains(groupKey)) {
-                        int existingGroupId = getGroupIdByName(folderName, parentGroupId);
-                        if (existingGroupId > 0) {
-                            targetGroupId = existingGroupId;
-                        } else {
-                            // 创建新分组
-                            bool createSuccess = createGroup(folderName, parentGroupId);
-                            if (createSuccess) {
-                                targetGroupId = getGroupIdByName(folderName, parentGroupId);
-                                if (targetGroupId <= 0) {
-                                    targetGroupId = parentGroupId;
-                                }
-                            }
-                        }
-                        m_importCreatedGroups.insert(groupKey, targetGroupId);
-                    } else {
-                        targetGroupId = m_importCreatedGroups.value(groupKey);
-                    }
-                }, Qt::BlockingQueuedConnection);
-                
-                // 导入图片
-                bool success = false;
-                QMetaObject::invokeMethod(this, [this, fileUrl, targetGroupId, &success]() {
-                    success = insertImage(fileUrl, targetGroupId);
-                }, Qt::BlockingQueuedConnection);
-                
-                if (success) {
-                    m_importSuccessCount++;
-                } else {
-                    QString error = "Failed to import image: " + fileName + ", Error: " + getLastError();
-                    emit importError(error);
-                }
-                
-                // 发送进度更新信号
-                QString currentFileName = QFileInfo(fileName).fileName();
-                emit importProgress(i + 1, m_importTotalCount, currentFileName, folderName);
-            }
-            
-        } catch (const std::exception &e) {
-            QString error = "Exception in import thread: " + QString::fromStdString(e.what());
-            emit importError(error);
-            return false;
-        } catch (...) {
-            emit importError("Unknown exception in import thread");
-            return false;
+
+    // 检查是否已经创建过该分组（仅由写入线程访问）
+    QString groupKey = QString("%1:%2").arg(parentGroupId).arg(folderName);
+    if (m_importCreatedGroups.contains(groupKey)) {
+        return m_importCreatedGroups.value(groupKey);
+    }
+
+    auto findGroup = [this, &folderName, parentGroupId]() {
+        CachedStatement query = cachedQuery(parentGroupId == -1
+                                                ? "SELECT id FROM groups WHERE name = ? AND parent_id IS NULL"
+                                                : "SELECT id FROM groups WHERE name = ? AND parent_id = ?");
+        query->addBindValue(folderName);
+        if (parentGroupId != -1) {
+            query->addBindValue(parentGroupId);
         }
-        
-        return !m_importCancelled;
+        if (!query.exec() || !query.next()) {
+            return -1;
+        }
+        return query.value(0).toInt();
     };
-    
-    // 启动异步导入
-    m_importWatcher->setFuture(QtConcurrent::run(importFunction));
+
+    int targetGroupId = findGroup();
+    if (targetGroupId <= 0) {
+        // 创建新分组
+        CachedStatement query = cachedQuery(parentGroupId > 0 ? "INSERT INTO groups (name, parent_id) VALUES (?, ?)"
+                                                              : "INSERT INTO groups (name) VALUES (?)");
+        query->addBindValue(folderName);
+        if (parentGroupId > 0) {
+            query->addBindValue(parentGroupId);
+        }
+        targetGroupId = query.exec() ? query->lastInsertId().toInt() : -1;
+        if (targetGroupId <= 0) {
+            targetGroupId = parentGroupId;
+        } else if (created) {
+            *created = true;
+        }
+    }
+
+    m_importCreatedGroups.insert(groupKey, targetGroupId);
+    return targetGroupId;
 }
 
 void Database::cancelAsyncImport()
@@ -1096,5 +3547,5 @@ void Database::cancelAsyncImport()
 void Database::onImportFinished()
 {
     bool success = m_importWatcher->result();
-    emit importFinished(success, m_importSuccessCount, m_importTotalCount);
+    emit importFinished(success, m_importSuccessCount, m_importTotalCount, m_importDuplicateCount);
 }
\ No newline at end of file
@@ -19,9 +19,146 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QImage>
+#include <QIODevice>
 #include <QUrl>
 #include <QtConcurrent>
 #include <QFutureWatcher>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QTimer>
+#include "statementcache.h"
+#include "queryprofiler.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// 发起查询的方法名（查询统计使用），编译器不支持时为空
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1926)
+#define IMAGEDB_CALLER_NAME __builtin_FUNCTION()
+#else
+#define IMAGEDB_CALLER_NAME nullptr
+#endif
+
+// 只解析文件头得到的图片元数据（尺寸和像素格式），导入时写入 image_meta
+struct ImageMetadata
+{
+    int width = 0;
+    int height = 0;
+    int pixelFormat = 0;   // QImage::Format（0 表示未知）
+    int colorDepth = 0;    // 每像素位数（0 表示未知）
+
+    bool isValid() const { return width > 0 && height > 0; }
+};
+
+// 导入流水线中已准备好的单张图片记录（文件读取、解码和缩略图生成均在工作线程完成）
+struct ImageRecord
+{
+    QString filePath;         // 源文件完整路径
+    QString fileName;         // 存入数据库的文件名
+    QString folderName;       // 来源文件夹名（用于自动分组）
+    QString imageFormat;      // 原始图片格式（JPG/PNG/...）
+    QByteArray imageData;     // 原始文件字节
+    QByteArray thumbnailData; // JPG格式缩略图
+    QList<QPair<int, QByteArray>> pyramidData; // 多分辨率缩略图（长边像素, JPG数据）
+    QByteArray contentHash;   // 原始字节的内容哈希（用于去重）
+    ImageMetadata metadata;   // 尺寸和像素格式（来自文件头）
+    int groupId = -1;         // 目标分组ID（<=0 表示未分组）
+    bool duplicate = false;   // 与库中已有图片内容完全相同（已跳过解码）
+    QString error;            // 准备失败时的错误信息
+
+    bool isValid() const { return error.isEmpty(); }
+};
+
+// 批量写入图片记录：复用同一条预编译语句，每 maxRows 行或 maxBytes 字节提交一次事务（以先到者为准）
+class ImageBatchWriter
+{
+public:
+    static constexpr int DefaultMaxRows = 200;
+    static constexpr qint64 DefaultMaxBytes = 64 * 1024 * 1024;
+
+    explicit ImageBatchWriter(const QSqlDatabase &db, int maxRows = DefaultMaxRows, qint64 maxBytes = DefaultMaxBytes);
+    ~ImageBatchWriter(); // 析构时提交尚未提交的记录
+
+    // 写入一条记录（在保存点内，失败时不留下任何行）
+    bool add(const ImageRecord &record);
+    bool commit();
+    // 每次事务提交成功后回调本次提交的图片ID（在写入线程中调用）
+    void setCommitCallback(std::function<void(const QList<int> &imageIds)> callback) { m_commitCallback = std::move(callback); }
+    QString lastError() const { return m_lastError; }
+    // 已成功提交的记录数（提交失败、整批回滚的记录不计入）
+    int insertedCount() const { return m_insertedCount; }
+    // 是否有已写入、尚未提交的记录
+    bool inTransaction() const { return m_inTransaction; }
+    // 开启查询统计时记录每条语句和每次提交的耗时（为空时不记录）
+    void setProfiler(QueryProfiler *profiler) { m_profiler = profiler; }
+
+    // 记录计入批次字节阈值的大小（原图、缩略图和各级缩略图）
+    static qint64 recordBytes(const ImageRecord &record);
+
+private:
+    bool writeRecord(const ImageRecord &record, int *imageId);
+    // 借用预编译语句执行，离开作用域时 finish()
+    CachedStatement statement(QSqlQuery &query, const char *caller = IMAGEDB_CALLER_NAME);
+
+    QSqlDatabase m_db;
+    QSqlQuery m_query;
+    QSqlQuery m_thumbnailQuery;
+    QSqlQuery m_metaQuery;
+    QSqlQuery m_hashQuery;
+    QSqlQuery m_pyramidQuery;
+    QSqlQuery m_savepointQuery;
+    QSqlQuery m_releaseQuery;
+    QSqlQuery m_rollbackToQuery;
+    int m_maxRows;
+    qint64 m_maxBytes;
+    bool m_inTransaction = false;
+    int m_pendingRows = 0;
+    qint64 m_pendingBytes = 0;
+    int m_insertedCount = 0;
+    QList<int> m_pendingIds;
+    std::function<void(const QList<int> &)> m_commitCallback;
+    QueryProfiler *m_profiler = nullptr;
+    QString m_lastError;
+};
+
+// 图片列表的一行（列表模型按窗口批量读取）
+struct ImageListEntry
+{
+    int id = -1;
+    int groupId = -1;      // 所属分组ID（未分组为 -1）
+    QString filename;
+    qint64 byteSize = 0;   // 原图字节数
+    int width = 0;         // 原图尺寸（尚未补齐元数据时为 0）
+    int height = 0;
+};
+
+// 导出计划中的一张图片：目标路径在分发给写入线程之前确定（已处理重名）
+struct ExportItem
+{
+    int imageId = -1;
+    QString targetPath; // 导出到文件夹时为完整路径，打包导出时为归档内的相对路径
+    QString fileName;   // 数据库中的原始文件名
+    QString groupPath;  // 所属分组相对导出根分组的路径（原始分组名，以"\\"分隔）
+};
+
+// getImageAsQImage 各阶段的耗时（纳秒），供图片管线跟踪使用
+struct ImageLoadTiming
+{
+    qint64 fetchNs = 0;  // 查询并读取缩略图数据；原图为读取格式并打开BLOB
+    qint64 decodeNs = 0; // 解码（开启增量BLOB读取时原图在解码过程中按块读取，读取时间计入此项）
+};
+
+// 分组表的一行（分组树模型一次扫描读取全部分组）
+struct GroupEntry
+{
+    int id = -1;
+    int parentId = -1;     // 父分组ID（根分组为 -1）
+    QString name;
+};
+
+class PooledConnection;
+struct PooledConnectionRegistry;
 
 class Database : public QObject
 {
@@ -31,7 +168,25 @@ public:
     explicit Database(QObject *parent = nullptr);
     ~Database();
 
+    // 导入时对内容完全相同的图片的处理方式
+    enum DuplicateMode {
+        ImportDuplicates = 0, // 照常导入
+        SkipDuplicates = 1    // 跳过（与库中已有图片重复时在解码之前跳过；本次导入中的重复按文件顺序保留第一份；
+                              // 旧版本导入的图片在后台补算哈希之前不参与比较）
+    };
+    Q_ENUM(DuplicateMode)
+
+    // 导出目标：文件夹，或单个不压缩的归档文件
+    enum ExportFormat {
+        ExportToFolder = 0,
+        ExportToTar = 1,
+        ExportToZip = 2
+    };
+    Q_ENUM(ExportFormat)
+
     Q_INVOKABLE bool initialize();
+    // 打开或创建指定路径的数据库（基准测试使用独立的数据库文件）
+    bool initialize(const QString &dbPath);
     Q_INVOKABLE bool insertImage(const QString &fileName, int groupId = -1);
     Q_INVOKABLE bool insertImage(const QUrl &fileUrl, int groupId = -1);
     bool insertImage(const QString &fileName, const QImage &image, int groupId = -1);
@@ -42,31 +197,88 @@ public:
     Q_INVOKABLE bool updateImageGroup(int imageId, int newGroupId);
     Q_INVOKABLE QString getLastError() const;
     Q_INVOKABLE int getImageByteSize(int imageId);
+    // 图片信息（文件名、格式、字节数、尺寸、像素格式、色深），不解码原图；尺寸未知时为 0
+    Q_INVOKABLE QVariantMap getImageInfo(int imageId);
+    // 一次查询读取多张图片的信息（已删除的图片不返回）
+    Q_INVOKABLE QVariantList getImageInfos(const QList<int> &imageIds);
+
+    // 图片列表模型使用：一次查询读取一页（id 大于 afterId 的前 limit 条，按 id 排序），
+    // groupId 的含义与 getAllImageIds 相同
+    QList<ImageListEntry> getImageListEntries(int groupId, int afterId, int limit);
+    // 读取指定图片的列表行（已删除的图片不返回），每块按 id 排序
+    QList<ImageListEntry> getImageListEntries(const QList<int> &imageIds);
     
+    // 返回当前线程专用的数据库连接（主线程返回主连接，工作线程按需创建，配置相同的PRAGMA）
+    QSqlDatabase threadConnection();
+    // 返回当前线程连接上的预编译语句（按 SQL 文本缓存，离开作用域时自动 finish()）
+    // 参数个数不固定的语句传 cache = false，避免缓存被只用一次的语句占满；caller 默认为调用方的方法名
+    CachedStatement cachedQuery(const QString &sql, bool cache = true, const char *caller = IMAGEDB_CALLER_NAME);
+    // 关闭后每次重新编译语句，用于基准测试对比
+    void setStatementCacheEnabled(bool enabled) { m_statementCacheEnabled = enabled; }
+    bool statementCacheEnabled() const { return m_statementCacheEnabled; }
+
+    // 查询统计（默认关闭）：记录经 cachedQuery 执行的每条语句的次数、耗时分布、行数和字节数，
+    // 以及导入批量写入的语句和提交、BLOB 流式读取（记为 "BLOB images.image_data"）；
+    // 只在启动时执行的建表、迁移检查和连接配置不计入。
+    // 慢查询立即输出警告；dumpIntervalMs > 0 时定期把统计摘要写入日志
+    Q_INVOKABLE void setQueryProfilingEnabled(bool enabled, int dumpIntervalMs = 60000);
+    Q_INVOKABLE bool queryProfilingEnabled() const { return m_queryProfilingEnabled; }
+    Q_INVOKABLE void setSlowQueryThreshold(double ms) { m_queryProfiler.setSlowThresholdMs(ms); }
+    // 统计快照：每条语句一项，按总耗时降序（字段见 QueryProfiler::snapshot）
+    Q_INVOKABLE QVariantList getQueryProfile() const { return m_queryProfiler.snapshot(); }
+    Q_INVOKABLE void resetQueryProfile() { m_queryProfiler.reset(); }
+
     // 新增：供QQuickImageProvider使用的方法
-    QImage getImageAsQImage(int id, bool useThumbnail = true);
+    // targetSize 有效时原图按目标尺寸解码（JPEG 在 DCT 域缩小），不会放大；originalSize 返回原图尺寸
+    // 请求缩略图时按 targetSize 选择能覆盖它的最小一级缩略图（140 → 320 → 800），都不够时才解码原图
+    // timing 不为空时返回读取和解码各自的耗时
+    QImage getImageAsQImage(int id, bool useThumbnail = true, const QSize &targetSize = QSize(),
+                            QSize *originalSize = nullptr, ImageLoadTiming *timing = nullptr);
+
+    // 读取文件、解码并生成缩略图（不访问数据库，可在任意线程调用）
+    // isDuplicate 返回 true 时跳过解码，记录标记为 duplicate
+    static ImageRecord prepareImageRecord(const QUrl &fileUrl,
+                                          const std::function<bool(const QByteArray &)> &isDuplicate = {});
+    static QByteArray computeContentHash(const QByteArray &data);
+
+    // 批量导入：一次事务组内写入多条已准备好的记录，返回成功提交的数量
+    int insertImages(const QList<ImageRecord> &records,
+                     int maxRows = ImageBatchWriter::DefaultMaxRows,
+                     qint64 maxBytes = ImageBatchWriter::DefaultMaxBytes);
+    // 脚本批量导入：并行准备文件后批量写入（同步执行）
+    Q_INVOKABLE int insertImageFiles(const QList<QUrl> &fileUrls, int groupId = -1);
     
     // 分组相关方法
     Q_INVOKABLE bool createGroup(const QString &name, int parentId = -1);
     Q_INVOKABLE QVariantList getAllGroups();
+    // 一次扫描读取全部分组（按名称排序），供分组树模型在内存中建立父子关系
+    QList<GroupEntry> getGroupEntries();
     Q_INVOKABLE QString getGroupName(int groupId);
     Q_INVOKABLE bool updateGroup(int groupId, const QString &name);
     Q_INVOKABLE bool updateGroupParent(int groupId, int newParentId); // 新增：更新分组的父分组ID
     Q_INVOKABLE bool deleteGroup(int groupId); // 删除分组（级联删除子分组和图片）
     Q_INVOKABLE int getSubgroupCount(int groupId); // 新增：获取子分组数量
-    Q_INVOKABLE int getImageCountForGroup(int groupId); // 新增：获取分组下的图片数量
+    Q_INVOKABLE int getImageCountForGroup(int groupId); // 新增：获取分组下的图片数量（groupId <= 0 为未分组）
     Q_INVOKABLE int getImageCountDirect(int groupId); // 新增：获取分组直接包含的图片数量（不包括子孙分组）
+    Q_INVOKABLE qint64 getGroupByteSize(int groupId); // 获取分组下图片的总字节数（包括子孙分组）
+    // 重新统计并与 group_stats 比较，不一致且 repair 为 true 时重建；返回最终是否一致
+    Q_INVOKABLE bool verifyGroupStats(bool repair = true);
     Q_INVOKABLE int getGroupIdByName(const QString &name, int parentId = -1);
 
     Q_INVOKABLE QString getGroupPath(int groupId); // 新增：获取分组完整路径
     Q_INVOKABLE QList<int> getAllDescendantGroupIds(int groupId); // 获取分组及其所有子孙分组ID
     
     // 异步导入相关方法
-    Q_INVOKABLE void startAsyncImport(const QList<QUrl> &fileUrls, int parentGroupId);
+    Q_INVOKABLE void startAsyncImport(const QList<QUrl> &fileUrls, int parentGroupId,
+                                      int duplicateMode = ImportDuplicates);
     Q_INVOKABLE void cancelAsyncImport();
     
     // 异步导出相关方法
-    Q_INVOKABLE void startAsyncExport(int groupId, const QString &groupName, const QString &targetFolder);
+    // recursive 为 true 时导出整个子树，子分组写入对应的子文件夹；
+    // format 为归档格式时在 targetFolder 中生成一个归档文件，writeManifest 为 true 时附带清单（路径、分组、哈希）
+    Q_INVOKABLE void startAsyncExport(int groupId, const QString &groupName, const QString &targetFolder,
+                                      bool recursive = false, int format = ExportToFolder,
+                                      bool writeManifest = false);
     Q_INVOKABLE void cancelAsyncExport();
     
     // 用户设置相关方法
@@ -74,10 +286,23 @@ public:
     Q_INVOKABLE QString getSetting(const QString &key, const QString &defaultValue = "");
     Q_INVOKABLE QVariantMap getAllSettings();
 
+    // WAL 状态：文件字节数、检查点次数、最近/最长检查点耗时（毫秒）、最近一次检查点时 WAL 中的帧数和已写回的帧数、
+    // 当前是否有批量写入
+    Q_INVOKABLE QVariantMap getWalStatus();
+
+    // 存储状态：页大小、页数、空闲页数、文件字节数、空闲字节数、碎片率（空闲页占比）、auto_vacuum 模式、
+    // 是否需要重建（页大小或清理模式与新建数据库不同）、是否已安排重建、最近一次后台整理释放的页数
+    Q_INVOKABLE QVariantMap getStorageStatus();
+    // 在下一个空闲周期执行后台整理（增量释放空闲页、更新查询统计信息）
+    Q_INVOKABLE void requestStorageMaintenance();
+    // 安排在下次启动时重建数据库（VACUUM），迁移到 DatabasePageSize 和增量清理模式；
+    // 修改页大小需要暂时离开 WAL 模式，只能在其他连接打开之前进行
+    Q_INVOKABLE bool requestStorageRebuild();
+
 signals:
     // 异步导入信号
     void importProgress(int current, int total, const QString &currentFile, const QString &currentFolder);
-    void importFinished(bool success, int importedCount, int totalCount);
+    void importFinished(bool success, int importedCount, int totalCount, int skippedDuplicates);
     void importError(const QString &error);
 
     // 异步导出信号
@@ -88,39 +313,172 @@ signals:
     // 图片尺寸信号（供ImageProvider使用）
     void imageSizeLoaded(int imageId, int width, int height);
 
+    // 图片被删除或修改，缓存中的对应项需要失效
+    void imageInvalidated(int imageId);
+
+    // 图片被添加、移动分组、重命名或删除（导入时在事务提交后从写入线程发射）
+    void imagesChanged(const QList<int> &imageIds);
+
+    // 分组结构变化，分组树模型据此增量更新（parentId 为 -1 表示根分组；导入时从写入线程发射）
+    void groupAdded(int groupId, int parentId, const QString &name);
+    void groupRenamed(int groupId, const QString &name);
+    void groupMoved(int groupId, int newParentId);
+    void groupRemoved(int groupId); // 子分组随之删除
+
+    // 后台检查点完成（从维护线程发射）
+    void walCheckpointed(qint64 walBytes, int walFrames, int checkpointedFrames, double elapsedMs);
+    // 后台整理完成（从维护线程发射）
+    void storageMaintenanceFinished(int freedPages, bool optimized, double elapsedMs);
+
 private slots:
     // 内部槽函数
     void onImportFinished();
     void onExportFinished();
+    void onMaintenanceTimer();
+    void onQueryProfileDump();
 
 private:
     QSqlDatabase m_db;
     QString m_lastError;
 
+    // 每个工作线程独占的连接（连接池），析构时通过 m_pooledConnections 释放线程仍未退出的连接
+    QThreadStorage<PooledConnection *> m_threadConnections;
+    std::shared_ptr<PooledConnectionRegistry> m_pooledConnections;
+    StatementCache m_statementCache; // 主连接的语句缓存，工作线程的缓存随各自的连接保存
+    std::atomic<bool> m_statementCacheEnabled;
+
+    // 查询统计（所有线程共用）
+    static constexpr int QueryProfileDumpStatements = 15; // 定期日志中列出的语句数
+    QueryProfiler m_queryProfiler;
+    std::atomic<bool> m_queryProfilingEnabled;
+    QTimer *m_queryProfileTimer;
+    // 开启统计时返回统计对象，供不经过 cachedQuery 的批量写入和 BLOB 读取使用
+    QueryProfiler *activeQueryProfiler() { return m_queryProfilingEnabled ? &m_queryProfiler : nullptr; }
+
+    // 流式读写BLOB时每次读取的块大小
+    static constexpr int BlobChunkSize = 256 * 1024;
+
+    // 导出：同时写文件的线程数上限，以及进度信号的最小间隔
+    static constexpr int MaxExportWriters = 4;
+    static constexpr int ExportProgressIntervalMs = 100;
+
+    // 数据库结构版本（PRAGMA user_version）
+    static constexpr int SchemaVersionNarrowThumbnails = 1; // 缩略图和元数据已迁移到窄表
+    static constexpr int SchemaVersionPyramid = 2;          // 已为旧图片生成多分辨率缩略图
+    static constexpr int SchemaVersionImageMetadata = 3;    // 已为旧图片补齐尺寸和像素格式
+    static constexpr int SchemaVersionContentHashes = 4;    // 已为旧图片补算内容哈希
+
+    // 缩略图尺寸：基础缩略图（image_thumbnails）的边界框，以及 image_pyramid 中各级的长边像素
+    static constexpr int ThumbnailWidth = 140;
+    static constexpr int ThumbnailHeight = 210;
+    static constexpr int PyramidLevels[] = { 320, 800 };
+
+    // 后台结构迁移
+    QFuture<void> m_migrationFuture;
+    std::atomic<bool> m_shuttingDown;
+
+    // 新建数据库使用的页大小（已有数据库需要重建才能修改）
+    static constexpr int DatabasePageSize = 8192;
+
+    // WAL 检查点调度：定时检查 WAL 文件，空闲（一个周期内没有增长）时在维护线程执行 PASSIVE 检查点；
+    // 批量写入期间只在 WAL 超过阈值时执行。连接的自动检查点阈值放宽为兜底，平时不会在提交时触发
+    static constexpr int CheckpointPollIntervalMs = 1000;
+    static constexpr qint64 BulkCheckpointThresholdBytes = 64 * 1024 * 1024;
+    static constexpr int WalAutoCheckpointPages = 16384;
+    static constexpr qint64 JournalSizeLimitBytes = 64 * 1024 * 1024;
+
+    struct WalStats
+    {
+        qint64 checkpointCount = 0;
+        double lastCheckpointMs = 0;
+        double maxCheckpointMs = 0;
+        int walFrames = 0;               // 最近一次检查点时 WAL 中的帧数
+        int checkpointedFrames = 0;      // 其中已写回数据库文件的帧数
+        qint64 checkpointedWalBytes = -1; // 最近一次全部写回时的 WAL 文件大小（大小不变时不再重复执行）
+    };
+
+    // 后台整理：WAL 已写回且没有写入时执行。增量清理每步释放少量页并短暂停顿，
+    // 单次最多释放 MaxVacuumPagesPerPass 页，剩余的留给下一个空闲周期，期间检查点照常进行
+    static constexpr int IncrementalVacuumStepPages = 256;
+    static constexpr int IncrementalVacuumPauseMs = 20;
+    static constexpr int MaxVacuumPagesPerPass = 8192;
+    static constexpr qint64 OptimizeIntervalMs = 60 * 60 * 1000; // 更新查询统计信息的最短间隔
+    static constexpr int AnalysisLimit = 1000;                   // ANALYZE 每个索引最多采样的行数
+
+    struct StorageStats
+    {
+        int lastFreedPages = 0;
+        double lastMaintenanceMs = 0;
+        qint64 lastOptimizeTime = 0; // 最近一次更新统计信息的时间（毫秒时间戳）
+    };
+
+    QThreadPool *m_maintenancePool; // 维护任务（检查点等）串行执行的单线程池
+    QTimer *m_maintenanceTimer;
+    QString m_walPath;
+    qint64 m_lastWalBytes;
+    std::atomic<bool> m_maintenanceRunning;
+    std::atomic<int> m_bulkWriters; // 正在批量写入的连接数
+    std::atomic<bool> m_storageMaintenanceRequested;
+    QMutex m_maintenanceMutex;
+    WalStats m_walStats;
+    StorageStats m_storageStats;
+
     // 辅助方法
-    QVariantList getGroupsRecursive(int parentId);
     bool createGroupsTable();
+    bool createGroupClosureTable();
+    bool rebuildGroupClosure();
+    bool createImageHashesTable();
+    bool createImageSideTables();
+    bool createImagePyramidTable();
+    bool createGroupStatsTable();
+    bool rebuildGroupStats();
+    QVariant readGroupStat(int groupId, const char *sql);
+    void startBackgroundMigrations();
+    bool migrateThumbnails();
+    bool backfillPyramid();
+    bool backfillImageMetadata();
+    bool backfillContentHashes();
+    static QString imageFormatForFile(const QString &fileName);
+    static ImageMetadata readImageMetadata(QIODevice *device, const QByteArray &format = QByteArray());
+    static QByteArray encodeThumbnail(const QImage &image);
+    static QList<QPair<int, QByteArray>> encodePyramid(const QImage &image);
+    static QString importFolderName(const QUrl &fileUrl);
+
+    static bool applyConnectionPragmas(QSqlDatabase &db, int cacheSizePages, QString *error);
+    qint64 walFileSize() const;
+    void runCheckpoint(qint64 walBytes);
+    void runStorageMaintenance(bool optimize);
+    bool rebuildStorage();
+    QList<ExportItem> planGroupExport(int groupId, const QString &groupName,
+                                      const QString &targetDir, bool recursive, bool avoidExistingFiles,
+                                      QStringList *directories);
+    int writeExportItems(const QList<ExportItem> &items, const QString &targetFolder);
+    int writeExportArchive(const QList<ExportItem> &items, const QString &archivePath, int format,
+                           bool writeManifest, const QString &targetFolder);
+    // 查找或创建导入目标分组；新建时 created 置为 true，由调用者在所在事务提交后发射 groupAdded
+    int resolveImportGroup(const QString &folderName, int parentGroupId, bool *created = nullptr);
     
     // 异步导入相关成员
     QFutureWatcher<bool> *m_importWatcher;
+    QThreadPool *m_importPool; // 解码/缩略图工作线程池
     QList<QUrl> m_importFileUrls;
     int m_importParentGroupId;
     int m_importCurrentIndex;
     int m_importTotalCount;
     int m_importSuccessCount;
-    bool m_importCancelled;
+    int m_importDuplicateCount;
+    std::atomic<bool> m_importCancelled;
     QMap<QString, int> m_importCreatedGroups;
     
     // 异步导出相关成员
     QFutureWatcher<bool> *m_exportWatcher;
+    QThreadPool *m_exportPool; // 并行写文件的工作线程池
     int m_exportGroupId;
     QString m_exportGroupName;
     QString m_exportTargetFolder;
-    QList<int> m_exportImageIds;
-    int m_exportCurrentIndex;
     int m_exportTotalCount;
     int m_exportSuccessCount;
-    bool m_exportCancelled;
+    std::atomic<bool> m_exportCancelled;
 };
 
 #endif // DATABASE_H
\ No newline at end of file
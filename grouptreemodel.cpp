@@ -0,0 +1,420 @@
+#include "grouptreemodel.h"
+
+GroupTreeModel::GroupTreeModel(Database *database, QObject *parent)
+    : QAbstractItemModel(parent),
+      m_database(database)
+{
+    // 导入时新建的分组从写入线程发射，自动以排队方式在主线程处理
+    connect(m_database, &Database::groupAdded, this, &GroupTreeModel::onGroupAdded);
+    connect(m_database, &Database::groupRenamed, this, &GroupTreeModel::onGroupRenamed);
+    connect(m_database, &Database::groupMoved, this, &GroupTreeModel::onGroupMoved);
+    connect(m_database, &Database::groupRemoved, this, &GroupTreeModel::onGroupRemoved);
+
+    reload();
+}
+
+QModelIndex GroupTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (row < 0 || column != 0) {
+        return QModelIndex();
+    }
+
+    auto it = m_nodes.constFind(idForIndex(parent));
+    if (it == m_nodes.constEnd() || !it->fetched || row >= it->children.size()) {
+        return QModelIndex();
+    }
+
+    return createIndex(row, 0, quintptr(qintptr(it->children.at(row))));
+}
+
+QModelIndex GroupTreeModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid()) {
+        return QModelIndex();
+    }
+
+    auto it = m_nodes.constFind(idForIndex(child));
+    if (it == m_nodes.constEnd()) {
+        return QModelIndex();
+    }
+
+    return indexForId(it->parentId);
+}
+
+int GroupTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+
+    auto it = m_nodes.constFind(idForIndex(parent));
+    if (it == m_nodes.constEnd() || !it->fetched) {
+        return 0;
+    }
+    return it->children.size();
+}
+
+int GroupTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return 1;
+}
+
+bool GroupTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return false;
+    }
+
+    // 子节点尚未暴露时也返回 true，视图据此显示展开按钮，展开时再调用 fetchMore
+    auto it = m_nodes.constFind(idForIndex(parent));
+    return it != m_nodes.constEnd() && !it->children.isEmpty();
+}
+
+QVariant GroupTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    auto it = m_nodes.constFind(idForIndex(index));
+    if (it == m_nodes.constEnd()) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case IdRole:
+        return it->id;
+    case Qt::DisplayRole:
+    case NameRole:
+        return it->name;
+    case ParentIdRole:
+        return it->parentId > 0 ? it->parentId : -1;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> GroupTreeModel::roleNames() const
+{
+    return {
+        { IdRole, "id" },
+        { NameRole, "name" },
+        { ParentIdRole, "parentId" }
+    };
+}
+
+bool GroupTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    auto it = m_nodes.constFind(idForIndex(parent));
+    return it != m_nodes.constEnd() && !it->fetched && !it->children.isEmpty();
+}
+
+void GroupTreeModel::fetchMore(const QModelIndex &parent)
+{
+    const int id = idForIndex(parent);
+    auto it = m_nodes.constFind(id);
+    if (it == m_nodes.constEnd() || it->fetched) {
+        return;
+    }
+
+    const int count = it->children.size();
+    if (count == 0) {
+        m_nodes[id].fetched = true;
+        return;
+    }
+
+    beginInsertRows(parent, 0, count - 1);
+    m_nodes[id].fetched = true;
+    endInsertRows();
+}
+
+void GroupTreeModel::reload()
+{
+    beginResetModel();
+    m_nodes.clear();
+
+    Node root;
+    root.id = RootId;
+    root.parentId = RootId;
+    root.fetched = true;
+    root.children.append(UngroupedId);
+    m_nodes.insert(RootId, root);
+
+    Node ungrouped;
+    ungrouped.id = UngroupedId;
+    ungrouped.parentId = RootId;
+    ungrouped.name = QStringLiteral("未分组");
+    ungrouped.fetched = true;
+    m_nodes.insert(UngroupedId, ungrouped);
+
+    // 一次扫描读取全部分组，先建立节点，再按查询顺序（已按名称排序）挂到父节点下
+    const QList<GroupEntry> entries = m_database->getGroupEntries();
+    m_nodes.reserve(entries.size() + 2);
+    for (const GroupEntry &entry : entries) {
+        Node node;
+        node.id = entry.id;
+        node.parentId = modelParentId(entry.parentId);
+        node.name = entry.name;
+        m_nodes.insert(entry.id, node);
+    }
+    for (const GroupEntry &entry : entries) {
+        // 父分组不存在的孤立分组与原来一样不显示
+        auto parentIt = m_nodes.find(modelParentId(entry.parentId));
+        if (parentIt != m_nodes.end()) {
+            parentIt->children.append(entry.id);
+        }
+    }
+
+    endResetModel();
+}
+
+bool GroupTreeModel::isDescendant(int groupId, int ancestorId) const
+{
+    auto it = m_nodes.constFind(groupId);
+    if (it == m_nodes.constEnd() || groupId == RootId) {
+        return false;
+    }
+
+    // 沿父节点向上查找；层数不会超过节点总数，防止数据异常时死循环
+    int id = it->parentId;
+    for (int depth = 0; depth < m_nodes.size() && id != RootId; ++depth) {
+        if (id == ancestorId) {
+            return true;
+        }
+        auto parentIt = m_nodes.constFind(id);
+        if (parentIt == m_nodes.constEnd()) {
+            return false;
+        }
+        id = parentIt->parentId;
+    }
+    return false;
+}
+
+void GroupTreeModel::onGroupAdded(int groupId, int parentId, const QString &name)
+{
+    const int modelParent = modelParentId(parentId);
+    if (groupId <= 0 || m_nodes.contains(groupId) || !m_nodes.contains(modelParent)) {
+        return;
+    }
+
+    Node node;
+    node.id = groupId;
+    node.parentId = modelParent;
+    node.name = name;
+    m_nodes.insert(groupId, node);
+    attach(groupId, modelParent);
+}
+
+void GroupTreeModel::onGroupRenamed(int groupId, const QString &name)
+{
+    if (groupId <= 0 || !m_nodes.contains(groupId)) {
+        return;
+    }
+
+    const int parentId = m_nodes.value(groupId).parentId;
+    const int oldRow = rowOf(groupId);
+    m_nodes[groupId].name = name;
+    if (oldRow < 0) {
+        return;
+    }
+
+    // 在去掉自身的兄弟列表中计算新位置
+    QList<int> &siblings = m_nodes[parentId].children;
+    siblings.removeAt(oldRow);
+    const int newRow = insertPosition(parentId, name);
+    siblings.insert(oldRow, groupId);
+
+    const bool exposed = rowsExposed(parentId);
+    if (newRow != oldRow) {
+        if (exposed) {
+            const QModelIndex parentIndex = indexForId(parentId);
+            // beginMoveRows 的目标位置以移动前的行号表示
+            const int destination = newRow > oldRow ? newRow + 1 : newRow;
+            beginMoveRows(parentIndex, oldRow, oldRow, parentIndex, destination);
+            m_nodes[parentId].children.move(oldRow, newRow);
+            endMoveRows();
+        } else {
+            m_nodes[parentId].children.move(oldRow, newRow);
+        }
+    }
+
+    if (exposed) {
+        const QModelIndex changed = indexForId(groupId);
+        emit dataChanged(changed, changed, { NameRole, Qt::DisplayRole });
+    }
+}
+
+void GroupTreeModel::onGroupMoved(int groupId, int newParentId)
+{
+    const int newParent = modelParentId(newParentId);
+    if (groupId <= 0 || !m_nodes.contains(groupId) || !m_nodes.contains(newParent)) {
+        return;
+    }
+
+    const int oldParent = m_nodes.value(groupId).parentId;
+    if (oldParent == newParent) {
+        return;
+    }
+
+    const int oldRow = rowOf(groupId);
+    if (oldRow >= 0 && rowsExposed(oldParent) && rowsExposed(newParent)) {
+        // 新旧父节点都已展开过：整体移动，保留子树在视图中的状态
+        const int newRow = insertPosition(newParent, m_nodes.value(groupId).name);
+        const bool newParentWasEmpty = m_nodes.value(newParent).children.isEmpty();
+        if (beginMoveRows(indexForId(oldParent), oldRow, oldRow, indexForId(newParent), newRow)) {
+            m_nodes[oldParent].children.removeAt(oldRow);
+            m_nodes[newParent].children.insert(newRow, groupId);
+            m_nodes[groupId].parentId = newParent;
+            endMoveRows();
+
+            if (m_nodes.value(oldParent).children.isEmpty()) {
+                notifyHasChildrenChanged(oldParent);
+            }
+            if (newParentWasEmpty) {
+                notifyHasChildrenChanged(newParent);
+            }
+            return;
+        }
+    }
+
+    detach(groupId);
+    attach(groupId, newParent);
+}
+
+void GroupTreeModel::onGroupRemoved(int groupId)
+{
+    if (groupId <= 0 || !m_nodes.contains(groupId)) {
+        return;
+    }
+
+    detach(groupId);
+    removeSubtree(groupId);
+}
+
+int GroupTreeModel::modelParentId(int parentId)
+{
+    // 数据库中 parent_id 为 NULL（-1）的分组挂在不可见的根节点下
+    return parentId > 0 ? parentId : RootId;
+}
+
+QModelIndex GroupTreeModel::indexForId(int id) const
+{
+    if (id == RootId) {
+        return QModelIndex();
+    }
+
+    const int row = rowOf(id);
+    if (row < 0) {
+        return QModelIndex();
+    }
+    return createIndex(row, 0, quintptr(qintptr(id)));
+}
+
+int GroupTreeModel::idForIndex(const QModelIndex &index) const
+{
+    return index.isValid() ? int(qintptr(index.internalId())) : RootId;
+}
+
+int GroupTreeModel::rowOf(int id) const
+{
+    auto it = m_nodes.constFind(id);
+    if (it == m_nodes.constEnd()) {
+        return -1;
+    }
+
+    auto parentIt = m_nodes.constFind(it->parentId);
+    if (parentIt == m_nodes.constEnd()) {
+        return -1;
+    }
+    return int(parentIt->children.indexOf(id));
+}
+
+bool GroupTreeModel::rowsExposed(int parentId) const
+{
+    // 节点的子行对视图可见，要求它自身及所有祖先都已 fetchMore
+    int id = parentId;
+    for (int depth = 0; depth <= m_nodes.size(); ++depth) {
+        auto it = m_nodes.constFind(id);
+        if (it == m_nodes.constEnd() || !it->fetched) {
+            return false;
+        }
+        if (id == RootId) {
+            return true;
+        }
+        id = it->parentId;
+    }
+    return false;
+}
+
+int GroupTreeModel::insertPosition(int parentId, const QString &name) const
+{
+    // 与 getGroupEntries 的 ORDER BY name 一致；根节点下"未分组"固定在第一行
+    const QList<int> &children = m_nodes.constFind(parentId)->children;
+    int row = (parentId == RootId) ? 1 : 0;
+    for (; row < children.size(); ++row) {
+        if (m_nodes.constFind(children.at(row))->name > name) {
+            break;
+        }
+    }
+    return row;
+}
+
+void GroupTreeModel::attach(int id, int parentId)
+{
+    m_nodes[id].parentId = parentId;
+    const int row = insertPosition(parentId, m_nodes.value(id).name);
+    const bool wasEmpty = m_nodes.value(parentId).children.isEmpty();
+
+    if (rowsExposed(parentId)) {
+        beginInsertRows(indexForId(parentId), row, row);
+        m_nodes[parentId].children.insert(row, id);
+        endInsertRows();
+    } else {
+        m_nodes[parentId].children.insert(row, id);
+    }
+
+    if (wasEmpty) {
+        notifyHasChildrenChanged(parentId);
+    }
+}
+
+void GroupTreeModel::detach(int id)
+{
+    const int parentId = m_nodes.value(id).parentId;
+    const int row = rowOf(id);
+    if (row < 0) {
+        return;
+    }
+
+    if (rowsExposed(parentId)) {
+        beginRemoveRows(indexForId(parentId), row, row);
+        m_nodes[parentId].children.removeAt(row);
+        endRemoveRows();
+    } else {
+        m_nodes[parentId].children.removeAt(row);
+    }
+
+    if (m_nodes.value(parentId).children.isEmpty()) {
+        notifyHasChildrenChanged(parentId);
+    }
+}
+
+void GroupTreeModel::notifyHasChildrenChanged(int id)
+{
+    // 展开按钮的显示取决于 hasChildren，通知视图刷新该行
+    if (id == RootId || !rowsExposed(m_nodes.value(id).parentId)) {
+        return;
+    }
+    const QModelIndex changed = indexForId(id);
+    emit dataChanged(changed, changed);
+}
+
+void GroupTreeModel::removeSubtree(int id)
+{
+    const QList<int> children = m_nodes.value(id).children;
+    for (int child : children) {
+        removeSubtree(child);
+    }
+    m_nodes.remove(id);
+}
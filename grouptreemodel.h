@@ -0,0 +1,83 @@
+/**
+ * @file grouptreemodel.h
+ * @brief 分组树模型
+ *
+ * 启动时一次扫描读取整个 groups 表，在内存中建立父子关系（邻接表）。
+ * 子节点在视图展开时才通过 fetchMore 暴露给视图，分组很多时界面只为可见的节点创建委托。
+ * 分组的新建、重命名、移动和删除通过 Database 的信号增量更新，不再重建整棵树。
+ * 第一行固定为"未分组"（ID 为 -1）。在 QML 中注册为 "groupTreeModel"。
+ */
+
+#ifndef GROUPTREEMODEL_H
+#define GROUPTREEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QList>
+#include "database.h"
+
+class GroupTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        NameRole,
+        ParentIdRole
+    };
+
+    explicit GroupTreeModel(Database *database, QObject *parent = nullptr);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // 重新读取整个分组表（正常情况下由信号增量更新，无需调用）
+    Q_INVOKABLE void reload();
+    // groupId 是否位于 ancestorId 的子树中（不包括 ancestorId 本身）
+    Q_INVOKABLE bool isDescendant(int groupId, int ancestorId) const;
+
+private slots:
+    void onGroupAdded(int groupId, int parentId, const QString &name);
+    void onGroupRenamed(int groupId, const QString &name);
+    void onGroupMoved(int groupId, int newParentId);
+    void onGroupRemoved(int groupId);
+
+private:
+    struct Node
+    {
+        int id = 0;
+        int parentId = 0;
+        QString name;
+        QList<int> children;  // 按名称排序的子分组ID
+        bool fetched = false; // 子节点是否已暴露给视图
+    };
+
+    // 不可见的根节点，以及固定在第一行的"未分组"节点
+    static constexpr int RootId = 0;
+    static constexpr int UngroupedId = -1;
+
+    static int modelParentId(int parentId);
+    QModelIndex indexForId(int id) const;
+    int idForIndex(const QModelIndex &index) const;
+    int rowOf(int id) const;
+    bool rowsExposed(int parentId) const;
+    int insertPosition(int parentId, const QString &name) const;
+    void attach(int id, int parentId);
+    void detach(int id);
+    void notifyHasChildrenChanged(int id);
+    void removeSubtree(int id);
+
+    Database *m_database;
+    QHash<int, Node> m_nodes; // 包括根节点和"未分组"节点
+};
+
+#endif // GROUPTREEMODEL_H
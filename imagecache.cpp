@@ -0,0 +1,100 @@
+#include "imagecache.h"
+
+ImageCache::ImageCache(qint64 budgetBytes, QObject *parent)
+    : QObject(parent),
+      m_budgetBytes(0),
+      m_hits(0),
+      m_misses(0)
+{
+    setBudgetBytes(budgetBytes);
+}
+
+bool ImageCache::lookup(int imageId, int variant, const QSize &size, QImage *image, bool recordStatistics)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (QImage *cached = m_cache.object(Key{imageId, variant, size})) {
+            *image = *cached; // QImage 隐式共享，这里不复制像素
+            if (recordStatistics) {
+                m_hits++;
+            }
+            return true;
+        }
+    }
+
+    if (recordStatistics) {
+        m_misses++;
+    }
+    return false;
+}
+
+void ImageCache::insert(int imageId, int variant, const QSize &size, const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // 超过总预算的单张图片会被 QCache 直接丢弃
+    m_cache.insert(Key{imageId, variant, size}, new QImage(image), image.sizeInBytes());
+}
+
+qint64 ImageCache::budgetBytes() const
+{
+    return m_budgetBytes;
+}
+
+void ImageCache::setBudgetBytes(qint64 budgetBytes)
+{
+    budgetBytes = qMax<qint64>(0, budgetBytes);
+    if (m_budgetBytes.exchange(budgetBytes) == budgetBytes) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_cache.setMaxCost(budgetBytes);
+    }
+
+    emit budgetBytesChanged();
+}
+
+void ImageCache::invalidate(int imageId)
+{
+    QMutexLocker locker(&m_mutex);
+    const QList<Key> keys = m_cache.keys();
+    for (const Key &key : keys) {
+        if (key.imageId == imageId) {
+            m_cache.remove(key);
+        }
+    }
+}
+
+void ImageCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+QVariantMap ImageCache::statistics() const
+{
+    qint64 entries = 0;
+    qint64 bytes = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        entries = m_cache.count();
+        bytes = m_cache.totalCost();
+    }
+
+    const quint64 hits = m_hits;
+    const quint64 misses = m_misses;
+
+    QVariantMap stats;
+    stats["hits"] = hits;
+    stats["misses"] = misses;
+    stats["hitRate"] = (hits + misses) > 0 ? double(hits) / double(hits + misses) : 0.0;
+    stats["entries"] = entries;
+    stats["bytes"] = bytes;
+    stats["budgetBytes"] = budgetBytes();
+    return stats;
+}
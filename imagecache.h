@@ -0,0 +1,79 @@
+/**
+ * @file imagecache.h
+ * @brief 已解码图片的内存缓存
+ *
+ * 以（图片ID, 缩略图/原图, 请求尺寸）为键缓存解码后的 QImage，按字节预算做 LRU 淘汰。
+ * 所有缓存项共用一个 LRU 和字节预算，单张图片只要不超过总预算就能缓存（4K 屏幕尺寸的原图约 33MB）。
+ * 一把锁保护整个缓存，临界区只做哈希查找和链表调整，多个加载线程可以并发访问。
+ * 在 QML 中注册为 "imageCache"，可查询命中统计和调整预算。
+ */
+
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QVariantMap>
+#include <atomic>
+
+class ImageCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 budgetBytes READ budgetBytes WRITE setBudgetBytes NOTIFY budgetBytesChanged)
+
+public:
+    // 缓存的图片种类
+    enum Variant {
+        Thumbnail = 0,
+        Original = 1,    // 按屏幕/请求尺寸解码的原图
+        FullOriginal = 2 // 未缩小的原图（1:1 查看）
+    };
+    Q_ENUM(Variant)
+
+    explicit ImageCache(qint64 budgetBytes, QObject *parent = nullptr);
+
+    // 命中时返回 true 并写入 image；recordStatistics 为 false 时不计入命中统计
+    bool lookup(int imageId, int variant, const QSize &size, QImage *image, bool recordStatistics = true);
+    void insert(int imageId, int variant, const QSize &size, const QImage &image);
+
+    qint64 budgetBytes() const;
+    void setBudgetBytes(qint64 budgetBytes);
+
+    // 删除某张图片的所有缓存项（删除、重命名图片时调用）
+    Q_INVOKABLE void invalidate(int imageId);
+    Q_INVOKABLE void clear();
+
+    // 统计信息：hits、misses、hitRate、entries、bytes、budgetBytes
+    Q_INVOKABLE QVariantMap statistics() const;
+
+signals:
+    void budgetBytesChanged();
+
+private:
+    struct Key
+    {
+        int imageId;
+        int variant;
+        QSize size;
+
+        bool operator==(const Key &other) const
+        {
+            return imageId == other.imageId && variant == other.variant && size == other.size;
+        }
+    };
+    friend size_t qHash(const Key &key, size_t seed) noexcept
+    {
+        return qHashMulti(seed, key.imageId, key.variant, key.size.width(), key.size.height());
+    }
+
+    mutable QMutex m_mutex;
+    QCache<Key, QImage> m_cache;
+    std::atomic<qint64> m_budgetBytes;
+    std::atomic<quint64> m_hits;
+    std::atomic<quint64> m_misses;
+};
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,208 @@
+#include "imagelistmodel.h"
+#include <QHash>
+#include <algorithm>
+
+ImageListModel::ImageListModel(Database *database, QObject *parent)
+    : QAbstractListModel(parent),
+      m_database(database),
+      m_groupId(-1),
+      m_hasMore(false)
+{
+    // 导入时从写入线程发射，自动以排队方式在主线程处理
+    connect(m_database, &Database::imagesChanged, this, &ImageListModel::onImagesChanged);
+}
+
+int ImageListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_entries.size();
+}
+
+QVariant ImageListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const ImageListEntry &entry = m_entries.at(index.row());
+    switch (role) {
+    case IdRole:
+        return entry.id;
+    case Qt::DisplayRole:
+    case FilenameRole:
+        return entry.filename;
+    case ByteSizeRole:
+        return entry.byteSize;
+    case ImageWidthRole:
+        return entry.width;
+    case ImageHeightRole:
+        return entry.height;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ImageListModel::roleNames() const
+{
+    return {
+        { IdRole, "id" },
+        { FilenameRole, "filename" },
+        { ByteSizeRole, "byteSize" },
+        { ImageWidthRole, "imageWidth" },
+        { ImageHeightRole, "imageHeight" }
+    };
+}
+
+bool ImageListModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return m_hasMore;
+}
+
+void ImageListModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || !m_hasMore) {
+        return;
+    }
+
+    const int afterId = m_entries.isEmpty() ? 0 : m_entries.last().id;
+    const QList<ImageListEntry> page = m_database->getImageListEntries(m_groupId, afterId, FetchBatchSize);
+    m_hasMore = (page.size() == FetchBatchSize);
+
+    if (page.isEmpty()) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_entries.size(), m_entries.size() + page.size() - 1);
+    m_entries.append(page);
+    endInsertRows();
+    emit countChanged();
+}
+
+int ImageListModel::groupId() const
+{
+    return m_groupId;
+}
+
+int ImageListModel::count() const
+{
+    return m_entries.size();
+}
+
+void ImageListModel::load(int groupId)
+{
+    const bool groupChanged = (m_groupId != groupId);
+
+    beginResetModel();
+    m_groupId = groupId;
+    // 第一页在重置期间读取，视图重建时即可显示，并且可以立即选中第一行
+    m_entries = m_database->getImageListEntries(m_groupId, 0, FetchBatchSize);
+    m_hasMore = (m_entries.size() == FetchBatchSize);
+    endResetModel();
+
+    if (groupChanged) {
+        emit groupIdChanged();
+    }
+    emit countChanged();
+}
+
+int ImageListModel::imageIdAt(int row) const
+{
+    if (row < 0 || row >= m_entries.size()) {
+        return -1;
+    }
+    return m_entries.at(row).id;
+}
+
+int ImageListModel::rowOfImage(int imageId) const
+{
+    const int row = lowerBound(imageId);
+    if (row < m_entries.size() && m_entries.at(row).id == imageId) {
+        return row;
+    }
+    return -1;
+}
+
+QList<int> ImageListModel::imageIds() const
+{
+    QList<int> ids;
+    ids.reserve(m_entries.size());
+    for (const ImageListEntry &entry : m_entries) {
+        ids.append(entry.id);
+    }
+    return ids;
+}
+
+void ImageListModel::onImagesChanged(const QList<int> &imageIds)
+{
+    // 重新读取这些图片的当前状态：已删除的不会返回，移动过的带有新的分组ID
+    QHash<int, ImageListEntry> current;
+    for (const ImageListEntry &entry : m_database->getImageListEntries(imageIds)) {
+        current.insert(entry.id, entry);
+    }
+
+    bool countDiffers = false;
+    for (int imageId : imageIds) {
+        const int row = rowOfImage(imageId);
+        auto it = current.constFind(imageId);
+        const bool visible = (it != current.constEnd() && belongsToGroup(it.value()));
+
+        if (!visible) {
+            // 删除或移出当前分组
+            if (row >= 0) {
+                beginRemoveRows(QModelIndex(), row, row);
+                m_entries.removeAt(row);
+                endRemoveRows();
+                countDiffers = true;
+            }
+            continue;
+        }
+
+        if (row >= 0) {
+            // 重命名等原地修改
+            m_entries[row] = it.value();
+            const QModelIndex changed = index(row);
+            emit dataChanged(changed, changed);
+            continue;
+        }
+
+        // 新增或移入当前分组；位于尚未读取的范围时留给 fetchMore，避免窗口中出现空洞
+        if (m_hasMore && (m_entries.isEmpty() || imageId > m_entries.last().id)) {
+            continue;
+        }
+        const int insertRow = lowerBound(imageId);
+        beginInsertRows(QModelIndex(), insertRow, insertRow);
+        m_entries.insert(insertRow, it.value());
+        endInsertRows();
+        countDiffers = true;
+    }
+
+    if (countDiffers) {
+        emit countChanged();
+    }
+}
+
+bool ImageListModel::belongsToGroup(const ImageListEntry &entry) const
+{
+    // 与 Database::getAllImageIds 的分组条件保持一致
+    if (m_groupId > 0) {
+        return entry.groupId == m_groupId;
+    }
+    if (m_groupId == -1) {
+        return entry.groupId <= 0;
+    }
+    return true;
+}
+
+int ImageListModel::lowerBound(int imageId) const
+{
+    auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), imageId,
+                               [](const ImageListEntry &entry, int id) {
+        return entry.id < id;
+    });
+    return int(it - m_entries.cbegin());
+}
@@ -0,0 +1,74 @@
+/**
+ * @file imagelistmodel.h
+ * @brief 图片列表模型
+ *
+ * 每页一次查询读取 id、文件名、字节数和原图尺寸，通过 canFetchMore/fetchMore 按需分页加载，
+ * 打开包含大量图片的分组时不再逐张查询。
+ * 图片被导入、移动、重命名或删除时（Database::imagesChanged）增量插入、更新或删除对应行，
+ * 不重建整个列表。在 QML 中注册为 "imageListModel"。
+ */
+
+#ifndef IMAGELISTMODEL_H
+#define IMAGELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include "database.h"
+
+class ImageListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int groupId READ groupId NOTIFY groupIdChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        FilenameRole,
+        ByteSizeRole,
+        ImageWidthRole,
+        ImageHeightRole
+    };
+
+    explicit ImageListModel(Database *database, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    int groupId() const;
+    int count() const;
+
+    // 加载指定分组的图片（groupId 的含义与 Database::getAllImageIds 相同），只读取第一页
+    Q_INVOKABLE void load(int groupId);
+    // 行号对应的图片ID，越界返回 -1
+    Q_INVOKABLE int imageIdAt(int row) const;
+    // 图片所在行号，未加载或不在列表中返回 -1
+    Q_INVOKABLE int rowOfImage(int imageId) const;
+    // 已加载的全部图片ID（按显示顺序）
+    Q_INVOKABLE QList<int> imageIds() const;
+
+signals:
+    void groupIdChanged();
+    void countChanged();
+
+private slots:
+    void onImagesChanged(const QList<int> &imageIds);
+
+private:
+    bool belongsToGroup(const ImageListEntry &entry) const;
+    int lowerBound(int imageId) const;
+
+    // 每次 fetchMore 读取的行数
+    static constexpr int FetchBatchSize = 256;
+
+    Database *m_database;
+    QList<ImageListEntry> m_entries; // 按 id 升序
+    int m_groupId;
+    bool m_hasMore;                  // 数据库中是否还有未读取的行
+};
+
+#endif // IMAGELISTMODEL_H
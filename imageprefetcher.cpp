@@ -0,0 +1,162 @@
+#include "imageprefetcher.h"
+#include "database.h"
+#include "imagecache.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QThread>
+
+ImagePrefetcher::ImagePrefetcher(Database *database, ImageCache *cache, QObject *parent)
+    : QObject(parent),
+      m_database(database),
+      m_cache(cache),
+      m_position(-1),
+      m_radius(2),
+      m_generation(0)
+{
+    // 预取是投机性的工作，线程数少于提供器，避免与当前图片的加载争抢CPU
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 2));
+    m_pool.setExpiryTimeout(-1);
+
+    // 与 ImageProvider 保持一致：/original 未指定尺寸时按屏幕物理像素解码
+    if (QScreen *screen = QGuiApplication::primaryScreen()) {
+        m_decodeSize = screen->size() * screen->devicePixelRatio();
+    }
+}
+
+ImagePrefetcher::~ImagePrefetcher()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+int ImagePrefetcher::radius() const
+{
+    return m_radius;
+}
+
+void ImagePrefetcher::setRadius(int radius)
+{
+    radius = qMax(0, radius);
+    if (m_radius == radius) {
+        return;
+    }
+    m_radius = radius;
+    emit radiusChanged();
+    schedule();
+}
+
+void ImagePrefetcher::setSequence(const QList<int> &imageIds, int position)
+{
+    m_sequence = imageIds;
+    m_position = position;
+    schedule();
+}
+
+void ImagePrefetcher::setPosition(int position)
+{
+    if (m_position == position) {
+        return;
+    }
+    m_position = position;
+    schedule();
+}
+
+void ImagePrefetcher::cancel()
+{
+    ++m_generation;
+    m_pool.clear();
+}
+
+void ImagePrefetcher::schedule()
+{
+    // 丢弃上一次调度中尚未开始的任务，正在解码的任务完成后仍会写入缓存
+    cancel();
+
+    if (m_position < 0 || m_position >= m_sequence.size() || m_radius == 0) {
+        return;
+    }
+
+    const quint64 generation = m_generation;
+
+    // 按距离由近到远排队，先后方向交替；前进方向更常用，优先于后退方向
+    for (int distance = 1; distance <= m_radius; ++distance) {
+        const int priority = m_radius - distance;
+        for (int index : { m_position + distance, m_position - distance }) {
+            if (index < 0 || index >= m_sequence.size()) {
+                continue;
+            }
+
+            const int imageId = m_sequence.at(index);
+            QImage cached;
+            if (m_cache->lookup(imageId, ImageCache::Original, QSize(), &cached, false)) {
+                continue;
+            }
+            {
+                QMutexLocker locker(&m_runningMutex);
+                if (m_running.contains(imageId)) {
+                    continue;
+                }
+            }
+
+            m_pool.start([this, imageId, generation]() {
+                prefetch(imageId, generation);
+            }, priority);
+        }
+    }
+}
+
+void ImagePrefetcher::prefetch(int imageId, quint64 generation)
+{
+    // 排队期间用户已跳到别处
+    if (generation != m_generation) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_runningMutex);
+        if (m_running.contains(imageId)) {
+            return;
+        }
+        m_running.insert(imageId);
+    }
+
+    QImage cached;
+    // 解码结果超过缓存总预算时放不进缓存，不做这次解码
+    if (!m_cache->lookup(imageId, ImageCache::Original, QSize(), &cached, false)
+        && estimatedDecodedBytes(imageId) <= m_cache->budgetBytes()) {
+        QSize originalSize;
+        QImage image = m_database->getImageAsQImage(imageId, false, m_decodeSize, &originalSize);
+        if (!image.isNull()) {
+            // 使用与提供器相同的缓存键（未指定请求尺寸），切换图片时直接命中
+            m_cache->insert(imageId, ImageCache::Original, QSize(), image);
+
+            // 提供器命中缓存时不会再发射尺寸信号，这里提前告知QML原图尺寸
+            QSize size = originalSize.isValid() ? originalSize : image.size();
+            emit m_database->imageSizeLoaded(imageId, size.width(), size.height());
+        }
+    }
+
+    QMutexLocker locker(&m_runningMutex);
+    m_running.remove(imageId);
+}
+
+qint64 ImagePrefetcher::estimatedDecodedBytes(int imageId) const
+{
+    QSize size = m_decodeSize;
+    const QVariantList infos = m_database->getImageInfos({ imageId });
+    if (!infos.isEmpty()) {
+        const QVariantMap info = infos.first().toMap();
+        const QSize originalSize(info.value("width").toInt(), info.value("height").toInt());
+        // 尚未补齐元数据的图片按解码尺寸上限估算
+        if (!originalSize.isEmpty()) {
+            size = originalSize;
+            if (m_decodeSize.isValid() && (size.width() > m_decodeSize.width() || size.height() > m_decodeSize.height())) {
+                size = size.scaled(m_decodeSize, Qt::KeepAspectRatio);
+            }
+        }
+    }
+    if (!size.isValid()) {
+        return 0;
+    }
+    return qint64(size.width()) * size.height() * 4;
+}
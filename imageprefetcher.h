@@ -0,0 +1,65 @@
+/**
+ * @file imageprefetcher.h
+ * @brief 查看器相邻图片预取
+ *
+ * 根据当前图片列表的顺序和位置，在后台线程中预先解码前后 radius 张原图
+ * （与 image://imageprovider/<id>/original 相同的屏幕尺寸），写入 ImageCache。
+ * 切换图片时提供器直接命中缓存，过渡动画无需等待解码。
+ * 位置跳变时尚未开始的预取任务会被丢弃。在 QML 中注册为 "imagePrefetcher"。
+ */
+
+#ifndef IMAGEPREFETCHER_H
+#define IMAGEPREFETCHER_H
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+#include <atomic>
+
+class Database;
+class ImageCache;
+
+class ImagePrefetcher : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int radius READ radius WRITE setRadius NOTIFY radiusChanged)
+
+public:
+    ImagePrefetcher(Database *database, ImageCache *cache, QObject *parent = nullptr);
+    ~ImagePrefetcher();
+
+    int radius() const;
+    void setRadius(int radius);
+
+    // 设置当前浏览的有序图片ID列表和位置（position 为 -1 时只更新列表）
+    Q_INVOKABLE void setSequence(const QList<int> &imageIds, int position = -1);
+    // 当前位置变化（键盘、滚轮、全屏切换）
+    Q_INVOKABLE void setPosition(int position);
+    // 丢弃所有尚未开始的预取任务
+    Q_INVOKABLE void cancel();
+
+signals:
+    void radiusChanged();
+
+private:
+    void schedule();
+    void prefetch(int imageId, quint64 generation);
+    // 按元数据中的原图尺寸估算解码结果的字节数（与提供器相同的解码尺寸，每像素4字节）
+    qint64 estimatedDecodedBytes(int imageId) const;
+
+    Database *m_database;
+    ImageCache *m_cache;
+    QList<int> m_sequence;
+    int m_position;
+    int m_radius;
+    QSize m_decodeSize;                // 与提供器 /original 相同的解码尺寸（屏幕物理像素）
+    QThreadPool m_pool;                // 预取专用线程池，不占用提供器的加载线程
+    std::atomic<quint64> m_generation; // 每次重新调度递增，旧任务据此放弃
+    QMutex m_runningMutex;
+    QSet<int> m_running;               // 正在解码的图片，重新调度时不再重复排队
+};
+
+#endif // IMAGEPREFETCHER_H
@@ -1,45 +1,200 @@
 #include "imageprovider.h"
+#include <QGuiApplication>
+#include <QScreen>
 
-ImageProvider::ImageProvider(Database *database)
-    : QQuickImageProvider(QQuickImageProvider::Image), m_database(database)
+ImageResponse::ImageResponse(Database *database, ImageCache *cache, QThreadPool *pool, ImageTracer *tracer,
+                             int imageId, int variant, const QSize &requestedSize, const QSize &decodeSize)
+    : m_database(database),
+      m_cache(cache),
+      m_pool(pool),
+      m_tracer(tracer),
+      m_imageId(imageId),
+      m_variant(variant),
+      m_requestedSize(requestedSize),
+      m_decodeSize(decodeSize),
+      m_enqueuedUs(0),
+      m_cancelled(false),
+      m_finished(false)
 {
-    // 构造函数，初始化数据库指针
+    // 响应对象由QML引擎负责释放，线程池不能删除它
+    setAutoDelete(false);
 }
 
-QImage ImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+void ImageResponse::enqueue(int priority)
 {
-    // 解析请求ID：格式为 "id" 或 "id/original"
-    QStringList parts = id.split("/");
-    int imageId = parts[0].toInt();
-    bool useThumbnail = (parts.size() == 1); // 默认使用缩略图
-    
-    if (parts.size() > 1 && parts[1] == "original") {
-        useThumbnail = false; // 请求原始图片
+    m_enqueuedUs = m_tracer->nowUs();
+    m_tracer->requestQueued();
+    m_pool->start(this, priority);
+}
+
+QQuickTextureFactory *ImageResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+void ImageResponse::cancel()
+{
+    m_cancelled = true;
+
+    // 尚未开始执行的任务直接从队列中移除；已在执行的任务会在下一步检查后尽快结束
+    if (m_pool->tryTake(this)) {
+        m_tracer->requestDequeued(false);
+        m_tracer->addInstant("cancelled", "image", m_imageId, m_variant);
+        finish();
+    }
+}
+
+void ImageResponse::finishWithImage(const QImage &image)
+{
+    m_image = image;
+    QMetaObject::invokeMethod(this, [this]() {
+        finish();
+    }, Qt::QueuedConnection);
+}
+
+void ImageResponse::run()
+{
+    const qint64 startUs = m_tracer->nowUs();
+    m_tracer->requestDequeued(true);
+    m_tracer->addSpan("queue wait", "image", m_enqueuedUs, startUs - m_enqueuedUs, m_imageId, m_variant);
+    // 整个请求的处理时间，各阶段嵌套在其中
+    TraceSpan requestSpan(m_tracer, "request", "image", m_imageId, m_variant);
+    auto finishRun = [this]() {
+        m_tracer->requestFinished();
+        finish();
+    };
+
+    if (m_cancelled) {
+        finishRun();
+        return;
+    }
+
+    // 排队期间可能已被其他请求放入缓存（请求时已计入统计，这里不重复计数）
+    QImage cached;
+    if (m_cache->lookup(m_imageId, m_variant, m_requestedSize, &cached, false)) {
+        m_tracer->addInstant("cache hit", "image", m_imageId, m_variant);
+        m_image = cached;
+        finishRun();
+        return;
+    }
+
+    // 从数据库获取图片（原图按目标尺寸解码）
+    const bool useThumbnail = (m_variant == ImageCache::Thumbnail);
+    QSize originalSize;
+    ImageLoadTiming timing;
+    const qint64 loadStartUs = m_tracer->nowUs();
+    QImage image = m_database->getImageAsQImage(m_imageId, useThumbnail, m_decodeSize, &originalSize, &timing);
+    m_tracer->addSpan("fetch", "image", loadStartUs, timing.fetchNs / 1000, m_imageId, m_variant);
+    m_tracer->addSpan("decode", "image", loadStartUs + timing.fetchNs / 1000, timing.decodeNs / 1000,
+                      m_imageId, m_variant);
+    m_tracer->recordDecode(timing.decodeNs / 1000);
+
+    if (m_cancelled) {
+        finishRun();
+        return;
     }
     
-    // 从数据库获取图片
-    QImage image = m_database->getImageAsQImage(imageId, useThumbnail);
-    
-    if (image.isNull()) {
+    const bool loaded = !image.isNull();
+    if (!loaded) {
         // 如果图片获取失败，返回一个默认的空图片
         image = QImage(100, 100, QImage::Format_RGB32);
         image.fill(Qt::red);
     }
     
-    // 设置返回的图片大小
-    if (size) {
-        *size = image.size();
-    }
-    
-    // 发射图片尺寸信号给QML（仅针对原始图片，避免频繁发射）
+    // 发射原图尺寸信号给QML（仅针对原始图片，避免频繁发射）
     if (!useThumbnail) {
-        emit m_database->imageSizeLoaded(imageId, image.size().width(), image.size().height());
+        QSize size = originalSize.isValid() ? originalSize : image.size();
+        emit m_database->imageSizeLoaded(m_imageId, size.width(), size.height());
     }
     
-    // 如果请求了特定大小，进行缩放
-    if (requestedSize.width() > 0 && requestedSize.height() > 0) {
-        image = image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // 如果请求了特定大小，进行缩放（只指定一个维度时另一维按比例计算）
+    {
+        TraceSpan scaleSpan(m_tracer, "scale", "image", m_imageId, m_variant);
+        if (m_requestedSize.width() > 0 && m_requestedSize.height() > 0) {
+            image = image.scaled(m_requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        } else if (m_requestedSize.width() > 0) {
+            image = image.scaledToWidth(m_requestedSize.width(), Qt::SmoothTransformation);
+        } else if (m_requestedSize.height() > 0) {
+            image = image.scaledToHeight(m_requestedSize.height(), Qt::SmoothTransformation);
+        }
     }
-    
-    return image;
+
+    m_image = image;
+    if (loaded) {
+        m_cache->insert(m_imageId, m_variant, m_requestedSize, image);
+    }
+    finishRun();
+}
+
+void ImageResponse::finish()
+{
+    // 取消和执行可能同时到达，finished 只能发射一次
+    if (!m_finished.exchange(true)) {
+        emit finished();
+    }
+}
+
+ImageProvider::ImageProvider(Database *database, ImageCache *cache, ImageTracer *tracer)
+    : m_database(database),
+      m_cache(cache),
+      m_tracer(tracer)
+{
+    // 线程数有上限，避免快速滚动时大量解码任务抢占CPU；线程常驻以复用各自的数据库连接
+    m_pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 4));
+    m_pool.setExpiryTimeout(-1);
+
+    // 查看器最多显示屏幕大小的图片，原图默认按屏幕物理像素解码
+    if (QScreen *screen = QGuiApplication::primaryScreen()) {
+        m_screenSize = screen->size() * screen->devicePixelRatio();
+    }
+}
+
+ImageProvider::~ImageProvider()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QQuickImageResponse *ImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    // 解析请求ID：格式为 "id"、"id/original" 或 "id/full"
+    QStringList parts = id.split("/");
+    int imageId = parts[0].toInt();
+    int variant = ImageCache::Thumbnail; // 默认使用缩略图
+
+    // 未指定的维度引擎可能传入 -1 或按设备像素比缩放后的负值，统一为 0（不限制）；
+    // 两维都未指定时使用空尺寸作为缓存键（与预取器一致）
+    QSize cacheSize;
+    if (requestedSize.width() > 0 || requestedSize.height() > 0) {
+        cacheSize = QSize(qMax(0, requestedSize.width()), qMax(0, requestedSize.height()));
+    }
+
+    // 缩略图按请求尺寸选择缩略图级别；原图未指定尺寸时只解码屏幕能显示的像素
+    QSize decodeSize = cacheSize;
+    if (parts.size() > 1) {
+        if (parts[1] == "full") {
+            variant = ImageCache::FullOriginal; // 1:1 原图，不缩小
+            decodeSize = QSize();
+        } else {
+            variant = ImageCache::Original; // 请求原始图片
+            if (!cacheSize.isValid()) {
+                decodeSize = m_screenSize;
+            }
+        }
+    }
+    const bool useThumbnail = (variant == ImageCache::Thumbnail);
+
+    ImageResponse *response = new ImageResponse(m_database, m_cache, &m_pool, m_tracer, imageId, variant,
+                                                cacheSize, decodeSize);
+
+    // 缓存命中时不进入线程池
+    QImage cached;
+    if (m_cache->lookup(imageId, variant, cacheSize, &cached)) {
+        m_tracer->addInstant("cache hit", "image", imageId, variant);
+        response->finishWithImage(cached);
+        return response;
+    }
+
+    response->enqueue(useThumbnail ? ThumbnailPriority : OriginalPriority);
+    return response;
 }
@@ -2,26 +2,83 @@
  * @file imageprovider.h
  * @brief 自定义图片提供器 - 供 QML 异步加载图片
  *
- * 注册为 "imageprovider"，QML 中通过 image://imageprovider/<id> 访问
- * 实现图片的懒加载和缓存，支持缩略图生成
+ * 注册为 "imageprovider"，QML 中通过 image://imageprovider/<id> 访问：
+ * - <id>           缩略图，按请求尺寸从多分辨率缩略图中选择合适的级别
+ * - <id>/original  原图，按请求尺寸（未指定时按屏幕尺寸）缩小解码
+ * - <id>/full      未缩小的原图，供 1:1 放大查看
+ * 基于 QQuickAsyncImageProvider，在独立的有界线程池中读取和解码图片：
+ * - 委托滚出可见区域时，引擎取消对应请求，尚未开始的任务直接从队列移除
+ * - 原图请求（/original）优先于缩略图请求
+ * - 解码结果写入 ImageCache，命中时不再查询数据库和解码
+ * 开启 ImageTracer 时记录每个请求的排队等待、读取、解码和缩放耗时
  */
 
 #ifndef IMAGEPROVIDER_H
 #define IMAGEPROVIDER_H
 
 #include <QQuickImageProvider>
+#include <QThreadPool>
+#include <QRunnable>
+#include <atomic>
 #include "database.h"
+#include "imagecache.h"
+#include "imagetracer.h"
 
-class ImageProvider : public QQuickImageProvider
+// 单个异步图片请求，同时作为线程池任务执行
+class ImageResponse : public QQuickImageResponse, public QRunnable
 {
 public:
-    ImageProvider(Database *database);
+    ImageResponse(Database *database, ImageCache *cache, QThreadPool *pool, ImageTracer *tracer,
+                  int imageId, int variant, const QSize &requestedSize, const QSize &decodeSize);
+
+    // 放入线程池（记录入队时间和队列深度）
+    void enqueue(int priority);
+
+    // 缓存命中时直接完成（finished 排队发射，保证引擎已连接信号）
+    void finishWithImage(const QImage &image);
+
+    QQuickTextureFactory *textureFactory() const override;
+    void cancel() override;
+    void run() override;
+
+private:
+    void finish();
+
+    Database *m_database;
+    ImageCache *m_cache;
+    QThreadPool *m_pool;
+    ImageTracer *m_tracer;
+    int m_imageId;
+    int m_variant;        // ImageCache::Variant
+    QSize m_requestedSize;
+    QSize m_decodeSize;   // 原图解码目标尺寸（无效表示不缩小）
+    QImage m_image;
+    qint64 m_enqueuedUs;  // 入队时间（跟踪时间基准）
+    std::atomic<bool> m_cancelled;
+    std::atomic<bool> m_finished;
+};
+
+class ImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    ImageProvider(Database *database, ImageCache *cache, ImageTracer *tracer);
+    ~ImageProvider();
     
-    // 重写requestImage方法，处理图片请求
-    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+    // 重写requestImageResponse方法，异步处理图片请求
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
     
 private:
+    // 请求优先级：原图优先于缩略图
+    enum Priority {
+        ThumbnailPriority = 0,
+        OriginalPriority = 1
+    };
+
     Database *m_database; // 数据库指针，用于获取图片数据
+    ImageCache *m_cache;  // 已解码图片缓存
+    ImageTracer *m_tracer; // 加载管线跟踪
+    QThreadPool m_pool;   // 专用的有界加载线程池
+    QSize m_screenSize;   // 屏幕物理像素尺寸，/original 未指定尺寸时的解码上限
 };
 
 #endif // IMAGEPROVIDER_H
@@ -0,0 +1,325 @@
+#include "imagetracer.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QQuickWindow>
+#include <QThread>
+#include <algorithm>
+
+ImageTracer::ImageTracer(QObject *parent)
+    : QObject(parent),
+      m_enabled(false),
+      m_nextEvent(0),
+      m_wrapped(false),
+      m_queued(0),
+      m_active(0),
+      m_syncStartUs(0),
+      m_renderStartUs(0),
+      m_lastSwapUs(0)
+{
+    m_clock.start();
+}
+
+void ImageTracer::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+
+    if (enabled) {
+        QMutexLocker locker(&m_mutex);
+        if (m_events.empty()) {
+            m_events.resize(MaxTraceEvents);
+        }
+        // 关闭期间的空闲时间不计为一帧
+        m_lastSwapUs = 0;
+    }
+    m_enabled = enabled;
+    emit enabledChanged();
+}
+
+int ImageTracer::threadIdLocked(const char *category)
+{
+    const Qt::HANDLE handle = QThread::currentThreadId();
+    auto it = m_threadIds.constFind(handle);
+    if (it != m_threadIds.constEnd()) {
+        return it.value();
+    }
+
+    // 线程首次出现时按记录的事件类别命名，导出时作为时间线上的线程名
+    QString name;
+    if (QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        name = "main";
+    } else if (qstrcmp(category, "frame") == 0) {
+        name = "render";
+    } else {
+        name = QString("image loader %1").arg(m_threadIds.size());
+    }
+
+    const int tid = m_threadNames.size();
+    m_threadNames.append(name);
+    m_threadIds.insert(handle, tid);
+    return tid;
+}
+
+void ImageTracer::appendEvent(Event event)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_events.empty()) {
+        return;
+    }
+    event.tid = threadIdLocked(event.category);
+    m_events[m_nextEvent] = event;
+    if (++m_nextEvent == qsizetype(m_events.size())) {
+        m_nextEvent = 0;
+        m_wrapped = true;
+    }
+}
+
+void ImageTracer::addSpan(const char *name, const char *category, qint64 startUs, qint64 durationUs,
+                          int imageId, int variant)
+{
+    if (!m_enabled) {
+        return;
+    }
+    appendEvent(Event{name, category, 'X', 0, startUs, qMax<qint64>(0, durationUs), imageId, variant, 0});
+}
+
+void ImageTracer::addInstant(const char *name, const char *category, int imageId, int variant)
+{
+    if (!m_enabled) {
+        return;
+    }
+    appendEvent(Event{name, category, 'i', 0, nowUs(), 0, imageId, variant, 0});
+}
+
+void ImageTracer::recordQueueDepth(int depth)
+{
+    if (!m_enabled) {
+        return;
+    }
+    appendEvent(Event{"queue depth", "image", 'C', 0, nowUs(), 0, -1, -1, depth});
+}
+
+void ImageTracer::requestQueued()
+{
+    recordQueueDepth(++m_queued);
+}
+
+void ImageTracer::requestDequeued(bool started)
+{
+    if (started) {
+        m_active++;
+    }
+    recordQueueDepth(--m_queued);
+}
+
+void ImageTracer::requestFinished()
+{
+    m_active--;
+}
+
+void ImageTracer::appendSample(QList<double> &samples, double value)
+{
+    if (samples.size() >= RecentSamples) {
+        samples.removeFirst();
+    }
+    samples.append(value);
+}
+
+void ImageTracer::recordDecode(qint64 durationUs)
+{
+    if (!m_enabled) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    appendSample(m_recentDecodes, durationUs / 1e3);
+}
+
+void ImageTracer::attachWindow(QQuickWindow *window)
+{
+    if (!window) {
+        return;
+    }
+
+    // 这些信号在渲染线程中发射（basic 渲染循环下为主线程），必须直接连接
+    connect(window, &QQuickWindow::beforeSynchronizing, this, [this]() {
+        if (m_enabled) {
+            m_syncStartUs = nowUs();
+        }
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterSynchronizing, this, [this]() {
+        if (m_enabled && m_syncStartUs > 0) {
+            addSpan("sync", "frame", m_syncStartUs, nowUs() - m_syncStartUs);
+        }
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::beforeRendering, this, [this]() {
+        if (m_enabled) {
+            m_renderStartUs = nowUs();
+        }
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering, this, [this]() {
+        if (m_enabled && m_renderStartUs > 0) {
+            addSpan("render", "frame", m_renderStartUs, nowUs() - m_renderStartUs);
+        }
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        if (!m_enabled) {
+            return;
+        }
+        const qint64 now = nowUs();
+        const qint64 last = m_lastSwapUs.exchange(now);
+        if (last > 0) {
+            const qint64 interval = now - last;
+            appendEvent(Event{"frame interval (us)", "frame", 'C', 0, now, 0, -1, -1, interval});
+            QMutexLocker locker(&m_mutex);
+            appendSample(m_recentFrames, interval / 1e3);
+        }
+    }, Qt::DirectConnection);
+}
+
+// 平均值、p95 和最大值
+static void summarize(QList<double> samples, double *average, double *p95, double *maximum)
+{
+    *average = *p95 = *maximum = 0;
+    if (samples.isEmpty()) {
+        return;
+    }
+    double total = 0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    *average = total / samples.size();
+    std::sort(samples.begin(), samples.end());
+    *p95 = samples.at(qMin(samples.size() - 1, qsizetype(samples.size() * 0.95)));
+    *maximum = samples.last();
+}
+
+QVariantMap ImageTracer::stats() const
+{
+    QList<double> decodes;
+    QList<double> frames;
+    qsizetype eventCount;
+    {
+        QMutexLocker locker(&m_mutex);
+        decodes = m_recentDecodes;
+        frames = m_recentFrames;
+        eventCount = m_wrapped ? qsizetype(m_events.size()) : m_nextEvent;
+    }
+
+    double decodeAvg, decodeP95, decodeMax;
+    summarize(decodes, &decodeAvg, &decodeP95, &decodeMax);
+    double frameAvg, frameP95, frameMax;
+    summarize(frames, &frameAvg, &frameP95, &frameMax);
+
+    QVariantList recentDecodes;
+    for (double sample : decodes) {
+        recentDecodes.append(sample);
+    }
+    QVariantList recentFrames;
+    for (double sample : frames) {
+        recentFrames.append(sample);
+    }
+
+    QVariantMap stats;
+    stats["queueDepth"] = qMax(0, m_queued.load());
+    stats["activeLoads"] = qMax(0, m_active.load());
+    stats["decodeCount"] = decodes.size();
+    stats["decodeAvgMs"] = decodeAvg;
+    stats["decodeP95Ms"] = decodeP95;
+    stats["decodeMaxMs"] = decodeMax;
+    stats["frameAvgMs"] = frameAvg;
+    stats["frameMaxMs"] = frameMax;
+    stats["fps"] = frameAvg > 0 ? 1000.0 / frameAvg : 0.0;
+    stats["recentDecodes"] = recentDecodes;
+    stats["recentFrames"] = recentFrames;
+    stats["eventCount"] = eventCount;
+    return stats;
+}
+
+QString ImageTracer::exportTrace(const QString &filePath)
+{
+    QString path = filePath;
+    if (path.isEmpty()) {
+        path = QDir(QCoreApplication::applicationDirPath())
+                   .filePath(QString("trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+    }
+
+    // 复制一份再生成 JSON，不在持锁期间阻塞加载线程和渲染线程
+    std::vector<Event> events;
+    QStringList threadNames;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_wrapped) {
+            events.assign(m_events.begin() + m_nextEvent, m_events.end());
+        }
+        events.insert(events.end(), m_events.begin(), m_events.begin() + m_nextEvent);
+        threadNames = m_threadNames;
+    }
+
+    QJsonArray traceEvents;
+    for (int tid = 0; tid < threadNames.size(); ++tid) {
+        traceEvents.append(QJsonObject{
+            {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", tid},
+            {"args", QJsonObject{{"name", threadNames.at(tid)}}}
+        });
+    }
+
+    for (const Event &event : events) {
+        QJsonObject object{
+            {"name", QString::fromLatin1(event.name)},
+            {"cat", QString::fromLatin1(event.category)},
+            {"ph", QString(QLatin1Char(event.phase))},
+            {"ts", event.startUs},
+            {"pid", 1},
+            {"tid", event.tid}
+        };
+
+        QJsonObject args;
+        if (event.phase == 'X') {
+            object.insert("dur", event.durationUs);
+        } else if (event.phase == 'i') {
+            object.insert("s", "t");
+        } else if (event.phase == 'C') {
+            args.insert("value", event.value);
+        }
+        if (event.imageId >= 0) {
+            args.insert("imageId", event.imageId);
+        }
+        if (event.variant >= 0) {
+            args.insert("variant", event.variant);
+        }
+        if (!args.isEmpty()) {
+            object.insert("args", args);
+        }
+        traceEvents.append(object);
+    }
+
+    QJsonObject root{{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}};
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to write trace file:" << path << file.errorString();
+        return QString();
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.close();
+
+    qInfo() << "Image pipeline trace written:" << path << events.size() << "events";
+    return path;
+}
+
+void ImageTracer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_nextEvent = 0;
+    m_wrapped = false;
+    m_recentDecodes.clear();
+    m_recentFrames.clear();
+}
@@ -0,0 +1,148 @@
+/**
+ * @file imagetracer.h
+ * @brief 图片加载管线跟踪和帧时间统计（可选开启）
+ *
+ * 记录每个图片请求在各阶段的耗时：排队等待、读取（查询/打开BLOB）、解码、缩放，
+ * 以及渲染线程每帧的同步（sync）和渲染（render）阶段——纹理上传和切换过渡的着色器都在渲染阶段内执行。
+ * 事件保存在固定大小的环形缓冲区中，可导出为 Chrome 跟踪格式（JSON），
+ * 用 chrome://tracing 或 Perfetto 打开即可按线程查看时间线。
+ *
+ * 在 QML 中注册为 "imageTracer"，性能浮层通过 stats() 读取加载队列深度、最近的解码耗时和帧时间。
+ * 未开启时各记录函数只检查一个原子标志；队列深度始终统计。可在任意线程记录。
+ */
+
+#ifndef IMAGETRACER_H
+#define IMAGETRACER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <atomic>
+#include <vector>
+
+class QQuickWindow;
+
+class ImageTracer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+
+public:
+    // 环形缓冲区容量（约 5MB），写满后覆盖最早的事件
+    static constexpr int MaxTraceEvents = 100000;
+    // 浮层统计使用的最近样本数
+    static constexpr int RecentSamples = 120;
+
+    explicit ImageTracer(QObject *parent = nullptr);
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+
+    // 跟踪时间基准（微秒，从创建跟踪器开始计）
+    qint64 nowUs() const { return m_clock.nsecsElapsed() / 1000; }
+
+    // 记录一个已完成的阶段；imageId/variant 小于 0 时不写入参数
+    void addSpan(const char *name, const char *category, qint64 startUs, qint64 durationUs,
+                 int imageId = -1, int variant = -1);
+    // 记录一个瞬时事件（如缓存命中、取消）
+    void addInstant(const char *name, const char *category, int imageId = -1, int variant = -1);
+
+    // 加载队列：进入线程池时 requestQueued()，开始执行或从队列移除时 requestDequeued()
+    void requestQueued();
+    void requestDequeued(bool started);
+    void requestFinished();
+    // 一次解码的耗时，进入浮层的最近解码统计
+    void recordDecode(qint64 durationUs);
+
+    // 连接窗口的渲染信号（直接连接，在渲染线程中记录）
+    void attachWindow(QQuickWindow *window);
+
+    // 浮层统计：queueDepth、activeLoads、decodeCount、decodeAvgMs、decodeP95Ms、decodeMaxMs、
+    // frameAvgMs、frameMaxMs、fps、recentDecodes、recentFrames（毫秒，按时间顺序）、eventCount
+    Q_INVOKABLE QVariantMap stats() const;
+    // 导出 Chrome 跟踪 JSON，路径为空时写入程序目录下的 trace-<时间>.json；返回文件路径，失败时返回空字符串
+    Q_INVOKABLE QString exportTrace(const QString &filePath = QString());
+    Q_INVOKABLE void clear();
+
+signals:
+    void enabledChanged();
+
+private:
+    struct Event
+    {
+        const char *name;
+        const char *category;
+        char phase;      // 'X' 阶段、'i' 瞬时、'C' 计数器
+        int tid;
+        qint64 startUs;
+        qint64 durationUs;
+        int imageId;
+        int variant;
+        qint64 value;    // 计数器的值
+    };
+
+    void appendEvent(Event event);
+    int threadIdLocked(const char *category);
+    void recordQueueDepth(int depth);
+    static void appendSample(QList<double> &samples, double value);
+
+    std::atomic<bool> m_enabled;
+    QElapsedTimer m_clock;
+
+    mutable QMutex m_mutex;
+    std::vector<Event> m_events; // 环形缓冲区，开启时分配
+    qsizetype m_nextEvent;
+    bool m_wrapped;
+    QHash<Qt::HANDLE, int> m_threadIds;
+    QStringList m_threadNames;   // 下标为 tid
+    QList<double> m_recentDecodes;
+    QList<double> m_recentFrames;
+
+    std::atomic<int> m_queued;
+    std::atomic<int> m_active;
+
+    // 只在渲染线程中访问（m_lastSwapUs 开启时由主线程清零）
+    qint64 m_syncStartUs;
+    qint64 m_renderStartUs;
+    std::atomic<qint64> m_lastSwapUs;
+};
+
+// 作用域内的阶段计时，析构时记录；跟踪器为空或未开启时不记录
+class TraceSpan
+{
+public:
+    TraceSpan(ImageTracer *tracer, const char *name, const char *category, int imageId = -1, int variant = -1)
+        : m_tracer(tracer && tracer->isEnabled() ? tracer : nullptr),
+          m_name(name),
+          m_category(category),
+          m_imageId(imageId),
+          m_variant(variant),
+          m_startUs(m_tracer ? m_tracer->nowUs() : 0)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (m_tracer) {
+            m_tracer->addSpan(m_name, m_category, m_startUs, m_tracer->nowUs() - m_startUs, m_imageId, m_variant);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    ImageTracer *m_tracer;
+    const char *m_name;
+    const char *m_category;
+    int m_imageId;
+    int m_variant;
+    qint64 m_startUs;
+};
+
+#endif // IMAGETRACER_H
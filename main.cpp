@@ -5,8 +5,14 @@
 #include <QFile>
 #include <QTextStream>
 #include <QQuickStyle>
+#include <QQuickWindow>
 #include "database.h"
 #include "imageprovider.h"
+#include "imagecache.h"
+#include "imagetracer.h"
+#include "imageprefetcher.h"
+#include "imagelistmodel.h"
+#include "grouptreemodel.h"
 
 // 自定义消息处理函数，用于捕获QML控制台输出
 void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
@@ -58,18 +64,49 @@ int main(int argc, char *argv[])
     }
     qDebug() << "Database initialized successfully";
     
-    // 创建QML引擎
-    QQmlApplicationEngine engine;
+    // 创建已解码图片缓存（预算可通过设置项 ImageCacheBudgetMB 调整，默认256MB）
+    qint64 cacheBudgetMB = database->getSetting("ImageCacheBudgetMB", "256").toLongLong();
+    ImageCache *imageCache = new ImageCache(cacheBudgetMB * 1024 * 1024, &app);
+    QObject::connect(database, &Database::imageInvalidated, imageCache, &ImageCache::invalidate);
+
+    // 查询统计（设置项 QueryProfiling 为 1 时开启，每 QueryProfileDumpSeconds 秒把摘要写入日志，默认60秒）
+    if (database->getSetting("QueryProfiling", "0") == "1") {
+        int dumpSeconds = database->getSetting("QueryProfileDumpSeconds", "60").toInt();
+        database->setQueryProfilingEnabled(true, dumpSeconds * 1000);
+    }
+
+    // 图片加载管线跟踪和帧时间统计（设置项 ImagePipelineTracing 为 1 时启动即开启，也可在性能浮层中开关）
+    ImageTracer *imageTracer = new ImageTracer(&app);
+    if (database->getSetting("ImagePipelineTracing", "0") == "1") {
+        imageTracer->setEnabled(true);
+    }
+
+    // 查看器相邻图片预取（需在数据库释放前销毁，见程序末尾）
+    ImagePrefetcher *imagePrefetcher = new ImagePrefetcher(database, imageCache);
+    
+    // 图片列表模型（分页读取，随导入/移动/删除增量更新）
+    ImageListModel *imageListModel = new ImageListModel(database, &app);
+
+    // 分组树模型（一次扫描读取全部分组，随新建/重命名/移动/删除增量更新）
+    GroupTreeModel *groupTreeModel = new GroupTreeModel(database, &app);
+
+    // 创建QML引擎（需先于数据库销毁，见程序末尾）
+    QQmlApplicationEngine *engine = new QQmlApplicationEngine;
     
     // 向QML注册C++类型和实例
-    engine.rootContext()->setContextProperty("database", database);
+    engine->rootContext()->setContextProperty("database", database);
+    engine->rootContext()->setContextProperty("imageCache", imageCache);
+    engine->rootContext()->setContextProperty("imagePrefetcher", imagePrefetcher);
+    engine->rootContext()->setContextProperty("imageListModel", imageListModel);
+    engine->rootContext()->setContextProperty("groupTreeModel", groupTreeModel);
+    engine->rootContext()->setContextProperty("imageTracer", imageTracer);
 
     // 注册自定义图片提供器，QML可以通过image://imageprovider/imageId访问
-    engine.addImageProvider("imageprovider", new ImageProvider(database));
+    engine->addImageProvider("imageprovider", new ImageProvider(database, imageCache, imageTracer));
     qDebug() << "QML engine configured";
     
     // 连接QML引擎的objectCreated信号
-    QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
+    QObject::connect(engine, &QQmlApplicationEngine::objectCreated,
                      &app, [](QObject *obj, const QUrl &objUrl) {
         qDebug() << "QML object created:" << objUrl.toString();
         if (!obj && objUrl.toString().contains("Main.qml")) {
@@ -79,7 +116,7 @@ int main(int argc, char *argv[])
     }, Qt::QueuedConnection);
     
     // 连接QML引擎的warnings信号
-    QObject::connect(&engine, &QQmlApplicationEngine::warnings,
+    QObject::connect(engine, &QQmlApplicationEngine::warnings,
                      &app, [](const QList<QQmlError> &warnings) {
         qWarning() << "QML warnings count:" << warnings.count();
         for (const QQmlError &warning : warnings) {
@@ -88,18 +125,25 @@ int main(int argc, char *argv[])
     });
     
     // 使用 loadFromModule 加载QML
-    engine.loadFromModule("ImageDBManager", "Main");
+    engine->loadFromModule("ImageDBManager", "Main");
     qDebug() << "QML module loaded";
     
     // 检查加载的根对象
-    const auto rootObjects = engine.rootObjects();
+    const auto rootObjects = engine->rootObjects();
     qDebug() << "Root objects loaded:" << rootObjects.count();
+
+    // 记录主窗口每帧的同步、渲染耗时和帧间隔
+    imageTracer->attachWindow(qobject_cast<QQuickWindow *>(rootObjects.value(0)));
     
     // 进入事件循环
     int result = app.exec();
     qDebug() << "Application exiting with result:" << result;
     
-    // 释放资源 - database 会通过 parent 自动释放，但这里显式释放更清晰
+    // 释放资源 - 图片提供器的加载线程和预取线程仍在使用数据库连接，必须先于 database 释放；
+    // 删除引擎会销毁窗口和 ImageProvider，后者清空队列并等待正在执行的加载任务
+    delete engine;
+    delete imagePrefetcher;
+    // database 会通过 parent 自动释放，但这里显式释放更清晰
     delete database;
     
     return result;
@@ -23,13 +23,11 @@ Item {
     function navigateWithWheel(delta) {
         if (delta > 0 && listView.currentIndex > 0) {
             listView.currentIndex--
-        } else if (delta < 0 && listView.currentIndex < imageModel.count - 1) {
+        } else if (delta < 0 && listView.currentIndex < imageListModel.count - 1) {
             listView.currentIndex++
         }
     }
 
-    ListModel { id: imageModel }
-    
     MouseArea {
         anchors.fill: parent
         onClicked: listView.forceActiveFocus()
@@ -49,13 +47,13 @@ Item {
 
     // 监听 currentIndex 变化，触发图片加载（用于键盘/滚轮/全屏切换）
     onCurrentIndexChanged: {
-        if (currentIndex >= 0 && currentIndex < imageModel.count) {
-            var item = imageModel.get(currentIndex)
-            if (item && item.id !== undefined) {
-                selectedImageId = item.id
-                imageSelected(item.id)
-            }
+        var imageId = imageListModel.imageIdAt(currentIndex)
+        if (imageId !== -1) {
+            selectedImageId = imageId
+            imageSelected(imageId)
         }
+        // 预取前后相邻的原图，切换时无需等待解码
+        imagePrefetcher.setPosition(currentIndex)
     }
 
     Component.onCompleted: loadImages()
@@ -67,36 +65,50 @@ Item {
         // 重置选中状态，确保新分组的图片能正常加载
         selectedImageId = -1
         currentIndex = -1
-        imageModel.clear()
-        var imageIds = database.getAllImageIds(currentGroupId)
-
-        for (var i = 0; i < imageIds.length; i++) {
-            var imageId = imageIds[i]
-            var filename = database.getImageFilename(imageId)
-
-            if (filename) {
-                imageModel.append({
-                    "id": imageId,
-                    "filename": filename
-                })
+        // 模型一次查询读取第一页，其余行在滚动到末尾时由视图按需读取
+        imageListModel.load(currentGroupId)
+
+        if (imageListModel.count > 0) {
+            currentIndex = 0
+        }
+    }
+
+    // 选中的图片被删除或移出当前分组后，选中同一位置上的图片
+    function refreshSelection() {
+        var imageId = imageListModel.imageIdAt(currentIndex)
+        if (imageId === -1 && imageListModel.count > 0) {
+            currentIndex = imageListModel.count - 1
+            return
+        }
+        if (imageId !== selectedImageId) {
+            selectedImageId = imageId
+            if (imageId !== -1) {
+                imageSelected(imageId)
             }
         }
+    }
 
-        if (imageModel.count > 0) {
-            currentIndex = 0
+    // 模型行数变化（分页读取、导入、移动、删除）时更新预取序列和选中状态
+    Connections {
+        target: imageListModel
+        function onCountChanged() {
+            imagePrefetcher.setSequence(imageListModel.imageIds(), listView.currentIndex)
+        }
+        function onRowsRemoved() {
+            Qt.callLater(refreshSelection)
         }
     }
 
     // 供外部调用获取当前图片数量
     function imageCount() {
-        return imageModel.count
+        return imageListModel.count
     }
     
     ListView {
         id: listView
         anchors.fill: parent
         anchors.margins: 5
-        model: imageModel
+        model: imageListModel
         delegate: imageDelegate
         clip: true
         cacheBuffer: 100
@@ -177,7 +189,10 @@ Item {
             // ===== CoverFlow 3D 变换核心 =====
             // 注释掉3D效果，使用普通列表显示
             property real thumbnailWidth: 110
-            property real thumbnailHeight: thumbnail.implicitHeight || 140
+            // 原图尺寸已知时直接按宽高比确定行高，缩略图加载完成前后行高不变
+            property real thumbnailHeight: model.imageWidth > 0
+                                           ? thumbnailWidth * model.imageHeight / model.imageWidth
+                                           : (thumbnail.implicitHeight || 140)
 
             height: thumbnailHeight + 10
 
@@ -216,6 +231,8 @@ Item {
                     width: thumbnailWidth
                     height: parent.height - 10
                     source: "image://imageprovider/" + model.id
+                    // 按显示宽度请求（引擎会乘以设备像素比），提供器据此选择合适的缩略图级别
+                    sourceSize.width: thumbnailWidth
                     fillMode: Image.PreserveAspectFit
                     Layout.alignment: Qt.AlignVCenter
                 }
@@ -385,6 +385,7 @@ Item {
             height: parent.height
             source: currentImage || ""
             fillMode: Image.PreserveAspectFit
+            retainWhileLoading: true  // 切换到 /full 原图时保留当前画面，避免闪烁
             opacity: 1.0
             x: imageOffset.x; y: imageOffset.y; scale: scaleFactor
             transformOrigin: Item.Center
@@ -576,6 +577,14 @@ Item {
                     var scaleDelta = event.angleDelta.y > 0 ? 0.9 : 1.1
                     scaleFactor *= scaleDelta
                     scaleFactor = Math.max(minScale, Math.min(maxScale, scaleFactor))
+
+                    // 放大超过适应窗口大小后，按屏幕尺寸解码的图片会丢失细节，切换为未缩小的原图
+                    if (scaleFactor > 1.0 && currentImageId !== -1) {
+                        var fullUrl = "image://imageprovider/" + currentImageId + "/full"
+                        if (currentImageItem.source.toString() !== fullUrl) {
+                            currentImageItem.source = fullUrl
+                        }
+                    }
                     
                     // 应用边界约束
                     constrainImageOffset()
@@ -160,6 +160,25 @@ ApplicationWindow {
         }
     }
 
+    // 性能浮层中最近样本的柱状图（毫秒），超过 limit 的样本标红
+    component SampleBars: Row {
+        id: sampleBars
+        property var samples: []
+        property real scaleMs: 33
+        property real limit: 16.7
+        height: 32
+        spacing: 1
+        Repeater {
+            model: sampleBars.samples
+            Rectangle {
+                width: 2
+                height: Math.max(1, Math.min(1, modelData / sampleBars.scaleMs) * sampleBars.height)
+                y: sampleBars.height - height
+                color: modelData > sampleBars.limit ? "#e05050" : "#60c080"
+            }
+        }
+    }
+
     // 可复用组件：主题化ComboBox
     component StyledComboBox: ComboBox {
         id: root
@@ -291,17 +310,10 @@ ApplicationWindow {
 
     // 获取当前分组图片数量（包括所有子孙分组）
     function updateImageCount(groupId) {
-        var count = 0;
-        if (groupId === -1) {
-            // 未分组：只统计未分组的图片
-            var imageIds = database.getAllImageIds(groupId);
-            count = imageIds.length;
-            console.log("Image count for ungrouped: " + count);
-        } else {
-            // 已分组：统计该分组及其所有子孙分组的图片
-            count = database.getImageCountForGroup(groupId);
-            console.log("Image count for group " + groupId + " (including descendants): " + count);
-        }
+        // 计数由数据库的分组统计表维护，按主键读取一行
+        // 未分组：只统计未分组的图片；已分组：统计该分组及其所有子孙分组的图片
+        var count = database.getImageCountForGroup(groupId);
+        console.log("Image count for group " + groupId + " (including descendants): " + count);
         return count;
     }
     
@@ -321,14 +333,17 @@ ApplicationWindow {
         }
         
         console.log("Getting info for image ID " + imageId);
-        var filename = database.getImageFilename(imageId);
+        // 文件名、字节数和尺寸在导入时已写入元数据，一次查询读取
+        var imageInfo = database.getImageInfo(imageId);
+        var filename = imageInfo.filename;
         console.log("Filename: " + filename);
         
-        var byteSize = database.getImageByteSize(imageId);
+        var byteSize = imageInfo.byteSize || 0;
         console.log("Byte size: " + byteSize);
         
-        // 从缓存获取图片尺寸，如果缓存中没有则使用默认值
-        var imageSize = imageSizeCache[imageId] || { width: 0, height: 0 };
+        // 元数据尚未补齐的旧图片回退到解码时缓存的尺寸
+        var imageSize = imageInfo.width > 0 ? { width: imageInfo.width, height: imageInfo.height }
+                                            : (imageSizeCache[imageId] || { width: 0, height: 0 });
         console.log("Image size: " + JSON.stringify(imageSize));
         
         // 格式化字节大小
@@ -341,8 +356,11 @@ ApplicationWindow {
             formattedSize = (byteSize / (1024 * 1024)).toFixed(2) + " MB";
         }
         
-        // 格式化尺寸（使用缓存的尺寸）
+        // 格式化尺寸和色深
         var formattedDimensions = imageSize.width > 0 ? (imageSize.width + "×" + imageSize.height) : "未知尺寸";
+        if (imageSize.width > 0 && imageInfo.colorDepth > 0) {
+            formattedDimensions += " " + imageInfo.colorDepth + "位";
+        }
         
         var info = filename + " - " + formattedSize + " - " + formattedDimensions;
         console.log("Current image info: " + info);
@@ -407,6 +425,110 @@ ApplicationWindow {
         }
     }
     
+    // 性能浮层（F12 开关）：图片加载队列深度、最近的解码耗时和帧时间，可导出 Chrome 跟踪文件
+    Shortcut {
+        sequence: "F12"
+        context: Qt.ApplicationShortcut
+        onActivated: performanceHud.visible = !performanceHud.visible
+    }
+
+    Rectangle {
+        id: performanceHud
+        visible: false
+        z: 1000
+        width: 300
+        height: hudColumn.implicitHeight + 20
+        anchors { top: parent.top; right: parent.right; topMargin: 44; rightMargin: 16 }
+        radius: 8
+        color: Qt.rgba(0, 0, 0, 0.75)
+        border.color: window.customAccent
+
+        property var stats: ({})
+        property string exportedPath: ""
+
+        // 浮层打开时开启跟踪（启动时已开启则保持开启）
+        property bool tracingWasEnabled: false
+        onVisibleChanged: {
+            if (visible) {
+                tracingWasEnabled = imageTracer.enabled
+                imageTracer.enabled = true
+                stats = imageTracer.stats()
+            } else if (!tracingWasEnabled) {
+                imageTracer.enabled = false
+            }
+        }
+
+        Timer {
+            interval: 250
+            repeat: true
+            running: performanceHud.visible
+            onTriggered: performanceHud.stats = imageTracer.stats()
+        }
+
+        ColumnLayout {
+            id: hudColumn
+            anchors { left: parent.left; right: parent.right; top: parent.top; margins: 10 }
+            spacing: 4
+
+            Text {
+                text: "加载队列 " + (performanceHud.stats.queueDepth || 0) +
+                      "，正在加载 " + (performanceHud.stats.activeLoads || 0)
+                color: "white"
+                font.pointSize: 9
+            }
+            Text {
+                text: "解码 平均 " + (performanceHud.stats.decodeAvgMs || 0).toFixed(1) +
+                      " ms，p95 " + (performanceHud.stats.decodeP95Ms || 0).toFixed(1) +
+                      " ms，最大 " + (performanceHud.stats.decodeMaxMs || 0).toFixed(1) + " ms"
+                color: "white"
+                font.pointSize: 9
+            }
+            SampleBars {
+                samples: performanceHud.stats.recentDecodes || []
+                scaleMs: 100
+                limit: 50
+            }
+            Text {
+                text: "帧 " + (performanceHud.stats.fps || 0).toFixed(0) +
+                      " fps，平均 " + (performanceHud.stats.frameAvgMs || 0).toFixed(1) +
+                      " ms，最大 " + (performanceHud.stats.frameMaxMs || 0).toFixed(1) + " ms"
+                color: "white"
+                font.pointSize: 9
+            }
+            SampleBars {
+                samples: performanceHud.stats.recentFrames || []
+            }
+            Text {
+                text: "跟踪事件 " + (performanceHud.stats.eventCount || 0)
+                color: "#a0a0a0"
+                font.pointSize: 8
+            }
+
+            RowLayout {
+                spacing: 6
+                ThemeColorButton {
+                    text: "导出跟踪"
+                    onClicked: performanceHud.exportedPath = imageTracer.exportTrace()
+                }
+                ThemeColorButton {
+                    text: "清空"
+                    onClicked: {
+                        imageTracer.clear()
+                        performanceHud.exportedPath = ""
+                    }
+                }
+            }
+            Text {
+                visible: performanceHud.exportedPath !== ""
+                text: "已导出：" + performanceHud.exportedPath
+                color: "#a0a0a0"
+                font.pointSize: 8
+                wrapMode: Text.WrapAnywhere
+                Layout.fillWidth: true
+            }
+        }
+    }
+
     // 组件加载完成后初始化数据
     Component.onCompleted: {
         console.log("Main window initialized")
@@ -1240,6 +1362,7 @@ ApplicationWindow {
 
         // 导入图片相关属性
         property var selectedFiles: []
+        property bool skipDuplicates: true // 跳过与库中内容完全相同的图片
 
         // 调整分组相关属性
         property int groupToMoveId: -1 // 要调整的分组ID
@@ -1296,6 +1419,15 @@ ApplicationWindow {
                 text: groupDialog.targetGroupWarning
             }
 
+            // 导入去重选项
+            CheckBox {
+                id: skipDuplicatesCheckBox
+                visible: groupDialog.dialogMode === "import"
+                text: "跳过内容完全相同的重复图片"
+                checked: groupDialog.skipDuplicates
+                onToggled: groupDialog.skipDuplicates = checked
+            }
+
             // 使用GroupTree组件代替ListView
             GroupTree {
                 id: dialogGroupTree
@@ -1364,8 +1496,6 @@ ApplicationWindow {
                         let success = database.createGroup(groupName, parentId)
                         if (success) {
                             console.log("Group created successfully")
-                            // 刷新GroupTree
-                            dialogGroupTree.loadGroups()
                             // 清空输入框
                             groupNameInput.text = ""
                         } else {
@@ -1403,10 +1533,8 @@ ApplicationWindow {
             }
         }
         
-        // 对话框打开时刷新分组树数据
+        // 对话框打开时初始化提示信息（分组树模型随分组变化自动更新，无需刷新）
         onOpened: {
-            dialogGroupTree.loadGroups()
-
             // 初始化提示文本
             if (groupDialog.dialogMode === "import") {
                 groupDialog.targetGroupName = "未分组"
@@ -1457,10 +1585,8 @@ ApplicationWindow {
                     return
                 }
 
-                // 2. 执行图片分组调整
+                // 2. 执行图片分组调整（图片列表模型会增量移除/插入该行）
                 database.updateImageGroup(imageToMove, targetGroup)
-                // 3. 重新加载图片列表
-                imageList.loadImages()
                 console.log("=== Image move completed: " + imageToMove + " -> " + targetGroup + " ===")
             } else {
                 // 调整分组
@@ -1489,8 +1615,6 @@ ApplicationWindow {
 
                 // 4. 执行分组调整
                 database.updateGroupParent(groupToMove, targetGroup)
-                // 5. 重新加载分组数据
-                groupTree.loadGroups()
                 console.log("=== Group move completed: " + groupToMove + " -> " + targetGroup + " ===")
             }
         }
@@ -1515,17 +1639,10 @@ ApplicationWindow {
             // 显示进度对话框
             importProgressDialog.open()
 
-            // 使用database的异步导入方法
-            database.startAsyncImport(selectedFiles, parentGroupId)
+            // 使用database的异步导入方法（1 = 跳过重复图片，0 = 照常导入）
+            database.startAsyncImport(selectedFiles, parentGroupId, groupDialog.skipDuplicates ? 1 : 0)
             console.log("异步导入已启动")
         }
-
-        // 对话框关闭时刷新分组树（包括取消按钮）
-        onRejected: {
-            console.log("Group dialog rejected/closed, refreshing group tree")
-            // 无论何时关闭对话框，都刷新分组树以显示可能新增的分组
-            groupTree.loadGroups()
-        }
     }
 
     // 右键菜单
@@ -1581,9 +1698,47 @@ ApplicationWindow {
             enabled: contextMenuGroupId !== -1 && database.getImageCountDirect(contextMenuGroupId) > 0
             onClicked: {
                 // 实现分组内图片导出功能
+                exportFolderDialog.recursive = false
+                exportFolderDialog.exportFormat = 0  // Database::ExportToFolder
                 exportFolderDialog.open();
             }
         }
+
+        MenuItem {
+            text: "导出分组及所有子分组（保留层级）"
+            enabled: contextMenuGroupId !== -1 && database.getSubgroupCount(contextMenuGroupId) > 0
+                     && database.getImageCountForGroup(contextMenuGroupId) > 0
+            onClicked: {
+                // 子分组导出为同名子文件夹，整棵子树一次导出
+                exportFolderDialog.recursive = true
+                exportFolderDialog.exportFormat = 0  // Database::ExportToFolder
+                exportFolderDialog.open();
+            }
+        }
+
+        // 打包导出：整个子树直接写入一个不压缩的归档文件，附带清单便于重新导入
+        Menu {
+            title: "打包导出（含子分组）"
+            enabled: contextMenuGroupId !== -1 && database.getImageCountForGroup(contextMenuGroupId) > 0
+
+            MenuItem {
+                text: "ZIP 文件"
+                onClicked: {
+                    exportFolderDialog.recursive = true
+                    exportFolderDialog.exportFormat = 2  // Database::ExportToZip
+                    exportFolderDialog.open();
+                }
+            }
+
+            MenuItem {
+                text: "TAR 文件"
+                onClicked: {
+                    exportFolderDialog.recursive = true
+                    exportFolderDialog.exportFormat = 1  // Database::ExportToTar
+                    exportFolderDialog.open();
+                }
+            }
+        }
     }
     
     // 重命名对话框
@@ -1614,15 +1769,11 @@ ApplicationWindow {
         onAccepted: {
             if (renameTextField.text.trim() !== "") {
                 if (isForImage) {
-                    // 调用数据库方法重命名图片
+                    // 调用数据库方法重命名图片（图片列表模型会原地更新该行）
                     database.renameImage(selectedGroupId, renameTextField.text.trim())
-                    // 重新加载图片列表 - 传递当前分组ID
-                    imageList.loadImages(window.currentGroupId)
                 } else {
                     // 调用数据库方法更新分组名称
                     database.updateGroup(selectedGroupId, renameTextField.text.trim())
-                    // 重新加载分组数据
-                    groupTree.loadGroups()
                 }
             }
         }
@@ -1709,15 +1860,11 @@ ApplicationWindow {
             if (deleteType === "group") {
                 // 删除分组
                 database.deleteGroup(itemId)
-                // 重新加载分组数据
-                groupTree.loadGroups()
                 // 重新加载图片列表
                 imageList.loadImages()
             } else if (deleteType === "image") {
-                // 删除图片
+                // 删除图片（图片列表模型会增量移除该行）
                 database.removeImage(itemId)
-                // 重新加载图片列表
-                imageList.loadImages()
             }
         }
     }
@@ -1924,9 +2071,9 @@ ApplicationWindow {
         }
         
         // 处理导入完成
-        function onImportFinished(success, importedCount, totalCount) {
+        function onImportFinished(success, importedCount, totalCount, skippedDuplicates) {
             importProgressDialog.close()
-            console.log("图片导入完成，共导入" + importedCount + "/" + totalCount + "张图片")
+            console.log("图片导入完成，共导入" + importedCount + "/" + totalCount + "张图片，跳过重复" + skippedDuplicates + "张")
             
             // 重置进度条值
             importProgressBar.value = 0
@@ -1934,8 +2081,10 @@ ApplicationWindow {
             currentImageText.text = "正在导入: 准备中..."
             currentFolderText.text = "正在导入到分组: 准备中..."
             
-            // 首先，确保分组树已经完全加载
-            groupTree.loadGroups();
+            // 有重复图片被跳过时提示用户
+            if (skippedDuplicates > 0) {
+                showInfoDialog("导入完成", "成功导入 " + importedCount + "/" + totalCount + " 张图片，跳过 " + skippedDuplicates + " 张重复图片")
+            }
         }
         
         // 处理导入错误
@@ -2023,6 +2172,11 @@ ApplicationWindow {
     FolderDialog {
         id: exportFolderDialog
         title: "选择导出目标文件夹"
+
+        // 是否连同子分组一起导出
+        property bool recursive: false
+        // 导出到文件夹或归档文件（Database::ExportFormat：0 文件夹，1 TAR，2 ZIP）
+        property int exportFormat: 0
         
         onAccepted: {
             // 实现图片导出逻辑
@@ -2039,7 +2193,8 @@ ApplicationWindow {
             exportProgressDialog.open()
             
             // 调用异步导出函数
-            database.startAsyncExport(groupId, groupName, targetFolder)
+            database.startAsyncExport(groupId, groupName, targetFolder, recursive, exportFormat,
+                                      exportFormat !== 0)
         }
     }
     
@@ -2078,6 +2233,15 @@ ApplicationWindow {
 
         width: 480
 
+        // 数据库存储状态（每次打开时刷新）
+        property var storageStatus: ({})
+
+        function refreshStorageStatus() {
+            storageStatus = database.getStorageStatus()
+        }
+
+        onOpened: refreshStorageStatus()
+
         ColumnLayout {
             anchors.fill: parent
             anchors.margins: 20
@@ -2112,6 +2276,34 @@ ApplicationWindow {
                 Layout.preferredWidth: 420
             }
 
+            // 数据库文件大小、页大小和空闲空间（空闲页由后台逐步释放）
+            Text {
+                property var status: aboutDialog.storageStatus
+                text: status.pageSize === undefined ? "" :
+                      "数据库：" + (status.fileBytes / (1024 * 1024)).toFixed(1) + " MB，页大小 " + status.pageSize +
+                      " 字节，空闲 " + (status.freeBytes / (1024 * 1024)).toFixed(1) + " MB（" +
+                      (status.fragmentation * 100).toFixed(1) + "%）" +
+                      (status.rebuildPending ? "\n将在下次启动时重建" :
+                       status.needsRebuild ? "\n旧版数据库格式，重建后可自动回收删除图片后的空间" : "")
+                font.pointSize: 10
+                color: getTextColor(window.customBackground)
+                wrapMode: Text.WordWrap
+                horizontalAlignment: Text.AlignHCenter
+                Layout.fillWidth: true
+                Layout.preferredWidth: 420
+            }
+
+            // 重建需要在其他连接打开之前进行，安排到下次启动时执行
+            ThemeColorButton {
+                text: "下次启动时重建数据库"
+                visible: aboutDialog.storageStatus.needsRebuild === true && !aboutDialog.storageStatus.rebuildPending
+                Layout.alignment: Qt.AlignHCenter
+                onClicked: {
+                    database.requestStorageRebuild()
+                    aboutDialog.refreshStorageStatus()
+                }
+            }
+
             Item { Layout.fillHeight: true }
         }
     }
@@ -0,0 +1,153 @@
+#include "queryprofiler.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+
+QueryProfiler::QueryProfiler()
+    : m_slowThresholdNs(qint64(DefaultSlowThresholdMs * 1e6))
+{
+}
+
+int QueryProfiler::bucketForNs(qint64 nsecs)
+{
+    const double micros = qMax<double>(1.0, nsecs / 1e3);
+    return qBound(0, int(std::log2(micros) * HistogramBucketsPerOctave), HistogramBuckets - 1);
+}
+
+double QueryProfiler::percentileMs(const Entry &entry, double fraction)
+{
+    if (entry.count == 0) {
+        return 0;
+    }
+
+    // 返回百分位所在档的上界（误差不超过一档，约 19%），且不超过实际最大值
+    const qint64 target = qMax<qint64>(1, qint64(std::ceil(entry.count * fraction)));
+    qint64 cumulative = 0;
+    for (int bucket = 0; bucket < HistogramBuckets; ++bucket) {
+        cumulative += entry.histogram[bucket];
+        if (cumulative >= target) {
+            const double upperMicros = std::exp2(double(bucket + 1) / HistogramBucketsPerOctave);
+            return qMin(upperMicros / 1e3, entry.maxNs / 1e6);
+        }
+    }
+    return entry.maxNs / 1e6;
+}
+
+void QueryProfiler::record(const QString &sql, const char *caller, qint64 nsecs, qint64 rows, qint64 bytes)
+{
+    const bool slow = nsecs >= m_slowThresholdNs;
+    qint64 slowCount = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry &entry = m_entries[sql];
+        entry.count++;
+        entry.totalNs += nsecs;
+        entry.maxNs = qMax(entry.maxNs, nsecs);
+        entry.rows += rows;
+        entry.bytes += bytes;
+        entry.callers[caller]++;
+        entry.histogram[bucketForNs(nsecs)]++;
+        if (slow) {
+            slowCount = ++entry.slowCount;
+        }
+    }
+
+    // 同一条语句的慢查询按 1、2、4、8... 次输出，持续卡顿时不会刷屏
+    if (slow && (slowCount & (slowCount - 1)) == 0) {
+        qWarning().noquote() << QString("Slow query in %1: %2 ms, %3 rows (%4 slow so far): %5")
+                                    .arg(QString::fromLatin1(caller ? caller : "?"))
+                                    .arg(nsecs / 1e6, 0, 'f', 2)
+                                    .arg(rows)
+                                    .arg(slowCount)
+                                    .arg(sql.simplified());
+    }
+}
+
+QList<QPair<QString, QueryProfiler::Entry>> QueryProfiler::sortedEntries() const
+{
+    QList<QPair<QString, Entry>> entries;
+    {
+        QMutexLocker locker(&m_mutex);
+        entries.reserve(m_entries.size());
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            entries.append(qMakePair(it.key(), it.value()));
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const QPair<QString, Entry> &a, const QPair<QString, Entry> &b) {
+        return a.second.totalNs > b.second.totalNs;
+    });
+    return entries;
+}
+
+// 调用方按次数降序，格式为"方法名×次数"
+static QStringList formatCallers(const QHash<const char *, qint64> &callers)
+{
+    QList<QPair<qint64, QString>> sorted;
+    for (auto it = callers.constBegin(); it != callers.constEnd(); ++it) {
+        sorted.append(qMakePair(it.value(), QString::fromLatin1(it.key() ? it.key() : "?")));
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const QPair<qint64, QString> &a, const QPair<qint64, QString> &b) {
+        return a.first > b.first;
+    });
+
+    QStringList result;
+    for (const auto &caller : sorted) {
+        result.append(QString("%1×%2").arg(caller.second).arg(caller.first));
+    }
+    return result;
+}
+
+QVariantList QueryProfiler::snapshot() const
+{
+    QVariantList result;
+    for (const auto &pair : sortedEntries()) {
+        const Entry &entry = pair.second;
+        QVariantMap item;
+        item.insert("sql", pair.first.simplified());
+        item.insert("callers", formatCallers(entry.callers));
+        item.insert("count", entry.count);
+        item.insert("totalMs", entry.totalNs / 1e6);
+        item.insert("meanMs", entry.count > 0 ? entry.totalNs / 1e6 / entry.count : 0.0);
+        item.insert("p50Ms", percentileMs(entry, 0.50));
+        item.insert("p99Ms", percentileMs(entry, 0.99));
+        item.insert("maxMs", entry.maxNs / 1e6);
+        item.insert("rows", entry.rows);
+        item.insert("bytes", entry.bytes);
+        item.insert("slowCount", entry.slowCount);
+        result.append(item);
+    }
+    return result;
+}
+
+QString QueryProfiler::report(int limit) const
+{
+    const QList<QPair<QString, Entry>> entries = sortedEntries();
+    QStringList lines;
+    lines.append(QString("Query profile: %1 statements").arg(entries.size()));
+
+    for (int i = 0; i < entries.size() && i < limit; ++i) {
+        const Entry &entry = entries.at(i).second;
+        lines.append(QString("  %1x total %2 ms, p50 %3 ms, p99 %4 ms, max %5 ms, %6 rows, %7 bytes, %8 slow [%9] %10")
+                         .arg(entry.count)
+                         .arg(entry.totalNs / 1e6, 0, 'f', 1)
+                         .arg(percentileMs(entry, 0.50), 0, 'f', 3)
+                         .arg(percentileMs(entry, 0.99), 0, 'f', 3)
+                         .arg(entry.maxNs / 1e6, 0, 'f', 3)
+                         .arg(entry.rows)
+                         .arg(entry.bytes)
+                         .arg(entry.slowCount)
+                         .arg(formatCallers(entry.callers).join(", "))
+                         .arg(entries.at(i).first.simplified()));
+    }
+    return lines.join('\n');
+}
+
+void QueryProfiler::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
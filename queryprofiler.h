@@ -0,0 +1,69 @@
+/**
+ * @file queryprofiler.h
+ * @brief 查询性能统计（可选开启）
+ *
+ * 按 SQL 文本汇总每条语句的执行次数、耗时直方图（p50/p99）、返回行数和读取字节数，
+ * 并记录发起查询的 Database 方法名，用于定位界面卡顿和 N+1 查询。
+ * 耗时只计算 exec() 和 next() 内部（SQLite 执行和逐行读取），不包括调用方处理结果的时间。
+ * 可在任意线程记录。
+ */
+
+#ifndef QUERYPROFILER_H
+#define QUERYPROFILER_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVariantList>
+#include <array>
+#include <atomic>
+
+class QueryProfiler
+{
+public:
+    // 超过该耗时的单次执行记为慢查询（一帧的时间）
+    static constexpr double DefaultSlowThresholdMs = 16.0;
+
+    QueryProfiler();
+
+    // 记录一次执行：caller 为发起查询的方法名（静态字符串）
+    void record(const QString &sql, const char *caller, qint64 nsecs, qint64 rows, qint64 bytes);
+
+    // 每条语句一项（按总耗时降序）：sql、callers、count、totalMs、meanMs、p50Ms、p99Ms、maxMs、rows、bytes、slowCount
+    QVariantList snapshot() const;
+    // 日志用的文本摘要（总耗时最高的 limit 条语句）
+    QString report(int limit) const;
+    void reset();
+
+    void setSlowThresholdMs(double ms) { m_slowThresholdNs = qint64(ms * 1e6); }
+    double slowThresholdMs() const { return m_slowThresholdNs / 1e6; }
+
+private:
+    // 对数直方图：每 2 倍分 4 档，覆盖 1 微秒到约 1 小时
+    static constexpr int HistogramBucketsPerOctave = 4;
+    static constexpr int HistogramBuckets = 32 * HistogramBucketsPerOctave;
+
+    struct Entry
+    {
+        qint64 count = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+        qint64 rows = 0;
+        qint64 bytes = 0;
+        qint64 slowCount = 0;
+        QHash<const char *, qint64> callers; // 方法名 -> 次数
+        std::array<quint32, HistogramBuckets> histogram {};
+    };
+
+    static int bucketForNs(qint64 nsecs);
+    static double percentileMs(const Entry &entry, double fraction);
+    QList<QPair<QString, Entry>> sortedEntries() const;
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    std::atomic<qint64> m_slowThresholdNs;
+};
+
+#endif // QUERYPROFILER_H
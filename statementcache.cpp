@@ -0,0 +1,154 @@
+#include "statementcache.h"
+#include "queryprofiler.h"
+#include <utility>
+
+CachedStatement::CachedStatement(QSqlQuery *query, bool *inUse)
+    : m_query(query),
+      m_inUse(inUse)
+{
+}
+
+CachedStatement::CachedStatement(std::unique_ptr<QSqlQuery> query)
+    : m_query(query.get()),
+      m_inUse(nullptr),
+      m_owned(std::move(query))
+{
+}
+
+CachedStatement::CachedStatement(CachedStatement &&other) noexcept
+    : m_query(other.m_query),
+      m_inUse(other.m_inUse),
+      m_owned(std::move(other.m_owned)),
+      m_profiler(other.m_profiler),
+      m_caller(other.m_caller),
+      m_executed(other.m_executed),
+      m_elapsedNs(other.m_elapsedNs),
+      m_rows(other.m_rows),
+      m_bytes(other.m_bytes)
+{
+    other.m_query = nullptr;
+    other.m_inUse = nullptr;
+    other.m_profiler = nullptr;
+}
+
+CachedStatement::~CachedStatement()
+{
+    if (!m_query) {
+        return;
+    }
+    recordExecution();
+    // 重置语句（sqlite3_reset），结束本次使用期间打开的读事务；绑定值保留，下次使用时覆盖
+    m_query->finish();
+    if (m_inUse) {
+        *m_inUse = false;
+    }
+}
+
+bool CachedStatement::exec()
+{
+    if (!m_profiler) {
+        return m_query->exec();
+    }
+
+    // 同一语句多次执行（循环中重新绑定参数）时每次单独记录
+    recordExecution();
+    QElapsedTimer timer;
+    timer.start();
+    const bool success = m_query->exec();
+    m_elapsedNs = timer.nsecsElapsed();
+    m_executed = true;
+    return success;
+}
+
+bool CachedStatement::next()
+{
+    if (!m_profiler) {
+        return m_query->next();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool hasRow = m_query->next();
+    m_elapsedNs += timer.nsecsElapsed();
+    if (hasRow) {
+        m_rows++;
+    }
+    return hasRow;
+}
+
+QVariant CachedStatement::value(int index)
+{
+    QVariant value = m_query->value(index);
+    if (m_profiler) {
+        // BLOB 和文本按数据长度计，其他类型按 8 字节计
+        switch (value.typeId()) {
+        case QMetaType::QByteArray:
+            m_bytes += value.toByteArray().size();
+            break;
+        case QMetaType::QString:
+            m_bytes += value.toString().size() * qint64(sizeof(QChar));
+            break;
+        default:
+            m_bytes += 8;
+            break;
+        }
+    }
+    return value;
+}
+
+void CachedStatement::setProfiler(QueryProfiler *profiler, const char *caller)
+{
+    m_profiler = profiler;
+    m_caller = caller;
+}
+
+void CachedStatement::recordExecution()
+{
+    if (!m_profiler || !m_executed) {
+        return;
+    }
+    m_profiler->record(m_query->lastQuery(), m_caller, m_elapsedNs, m_rows, m_bytes);
+    m_executed = false;
+    m_elapsedNs = 0;
+    m_rows = 0;
+    m_bytes = 0;
+}
+
+StatementCache::~StatementCache()
+{
+    clear();
+}
+
+CachedStatement StatementCache::acquire(const QSqlDatabase &db, const QString &sql, bool cache)
+{
+    if (cache) {
+        auto it = m_entries.constFind(sql);
+        if (it != m_entries.constEnd()) {
+            Entry *entry = it.value();
+            if (!entry->inUse) {
+                m_hits++;
+                entry->inUse = true;
+                return CachedStatement(entry->query.get(), &entry->inUse);
+            }
+        }
+    }
+
+    m_misses++;
+    auto query = std::make_unique<QSqlQuery>(db);
+    // 编译失败的语句不缓存，调用方在 exec() 时从 lastError() 得到错误信息
+    if (!query->prepare(sql) || !cache || m_entries.contains(sql)) {
+        return CachedStatement(std::move(query));
+    }
+
+    Entry *entry = new Entry;
+    entry->query = std::move(query);
+    entry->inUse = true;
+    m_entries.insert(sql, entry);
+    return CachedStatement(entry->query.get(), &entry->inUse);
+}
+
+void StatementCache::clear()
+{
+    qDeleteAll(m_entries);
+    m_entries.clear();
+}
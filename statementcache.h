@@ -0,0 +1,97 @@
+/**
+ * @file statementcache.h
+ * @brief 按连接缓存的预编译语句
+ *
+ * 以 SQL 文本为键保存已 prepare() 的 QSqlQuery，同一条语句再次使用时跳过 SQL 解析和查询计划生成。
+ * 每个连接一份缓存，只能在拥有该连接的线程中使用。
+ *
+ * acquire() 返回的 CachedStatement 离开作用域时自动 finish()，不会让读事务一直保持打开；
+ * 同一条语句正在使用时（嵌套调用）再次请求会得到一个临时编译的语句，不会打断外层的结果集。
+ *
+ * 开启查询统计时，通过 CachedStatement::exec()/next()/value() 执行和读取的耗时、行数和字节数
+ * 记录到 QueryProfiler（直接通过 -> 调用 QSqlQuery 的部分不计入）。
+ */
+
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVariant>
+#include <memory>
+
+class QueryProfiler;
+
+class CachedStatement
+{
+public:
+    CachedStatement(QSqlQuery *query, bool *inUse);
+    explicit CachedStatement(std::unique_ptr<QSqlQuery> query);
+    CachedStatement(CachedStatement &&other) noexcept;
+    ~CachedStatement();
+
+    CachedStatement(const CachedStatement &) = delete;
+    CachedStatement &operator=(const CachedStatement &) = delete;
+    CachedStatement &operator=(CachedStatement &&) = delete;
+
+    QSqlQuery *operator->() const { return m_query; }
+    QSqlQuery &operator*() const { return *m_query; }
+
+    // 执行和逐行读取；开启统计时记录耗时、行数和读取的字节数
+    bool exec();
+    bool next();
+    QVariant value(int index);
+
+    // 开启统计：之后的每次 exec() 记录为一次执行，caller 为发起查询的方法名（静态字符串）
+    void setProfiler(QueryProfiler *profiler, const char *caller);
+
+private:
+    void recordExecution();
+
+    QSqlQuery *m_query;
+    bool *m_inUse;                     // 借用缓存中的语句时指向其占用标记
+    std::unique_ptr<QSqlQuery> m_owned; // 未缓存的临时语句
+
+    // 查询统计（m_profiler 为空时不记录）
+    QueryProfiler *m_profiler = nullptr;
+    const char *m_caller = nullptr;
+    bool m_executed = false;
+    qint64 m_elapsedNs = 0;
+    qint64 m_rows = 0;
+    qint64 m_bytes = 0;
+};
+
+class StatementCache
+{
+public:
+    StatementCache() = default;
+    ~StatementCache();
+
+    StatementCache(const StatementCache &) = delete;
+    StatementCache &operator=(const StatementCache &) = delete;
+
+    // 返回 sql 对应的预编译语句（首次使用时编译）；cache 为 false 时每次重新编译，用于对比测量
+    CachedStatement acquire(const QSqlDatabase &db, const QString &sql, bool cache = true);
+    // 释放全部语句（关闭连接之前调用，此时不能有借出的语句）
+    void clear();
+
+    int size() const { return m_entries.size(); }
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+
+private:
+    struct Entry
+    {
+        std::unique_ptr<QSqlQuery> query;
+        bool inUse = false;
+    };
+
+    QHash<QString, Entry *> m_entries;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
+
+#endif // STATEMENTCACHE_H